@@ -33,6 +33,7 @@ void Example1() {
     emitter.Call(AddressOf(HelloWorld));
     emitter.AddR64Imm8(RSP, 8);
     emitter.Ret();
+    emitter.EmitLiteralPool();
 
     buffer.Protect();
     buffer.Call();
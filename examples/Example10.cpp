@@ -129,6 +129,7 @@ void Example10() {
     emitter.MovR64R64(RSP, RBP);
     emitter.PopR64(RBP);
     emitter.Ret();
+    emitter.EmitLiteralPool();
 
     buffer.Protect();
     buffer.Call();
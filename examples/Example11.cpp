@@ -0,0 +1,110 @@
+#include "BlockAbi.h"
+#include "CodeBuffer.h"
+#include "EmitterX64.h"
+#include "HelperTable.h"
+#include "RecomilerState.h"
+#include "X64.h"
+#include "MIPS.h"
+
+namespace {
+
+void EmitAddu(rbrown::EmitterX64& emitter, uint32_t opcode) {
+    // Rd = Rs + Rt
+    using namespace rbrown;
+    EmitLoadGuestRegister(emitter, RAX, InstructionRs(opcode));
+    EmitLoadGuestRegister(emitter, RCX, InstructionRt(opcode));
+    emitter.AddR32R32(RAX, RCX);
+    EmitStoreGuestRegister(emitter, InstructionRd(opcode), RAX);
+}
+
+void EmitSubu(rbrown::EmitterX64& emitter, uint32_t opcode) {
+    // Rd = Rs - Rt
+    using namespace rbrown;
+    EmitLoadGuestRegister(emitter, RAX, InstructionRs(opcode));
+    EmitLoadGuestRegister(emitter, RCX, InstructionRt(opcode));
+    emitter.SubR32R32(RAX, RCX);
+    EmitStoreGuestRegister(emitter, InstructionRd(opcode), RAX);
+}
+
+void EmitAdd(rbrown::RecompilerState& state, rbrown::EmitterX64& emitter, uint32_t opcode) {
+    // Rd = Rs + Rt, trapping on overflow
+    using namespace rbrown;
+    Label setRegister = emitter.NewLabel();
+    EmitLoadGuestRegister(emitter, RAX, InstructionRs(opcode));
+    EmitLoadGuestRegister(emitter, RCX, InstructionRt(opcode));
+    emitter.AddR32R32(RAX, RCX);
+    emitter.Jno(setRegister);
+    // The processor is no longer an immediate, it's the context register
+    EmitStorePC(emitter, state.GetPC());
+    emitter.MovR64R64(RDI, CONTEXT);
+    emitter.MovR32Imm32(RSI, ARITHMETIC_OVERFLOW);
+    EmitCallHelper(emitter, HELPER_ENTER_EXCEPTION);
+    EmitBlockEpilogue(emitter);
+    emitter.Bind(setRegister);
+    EmitStoreGuestRegister(emitter, InstructionRd(opcode), RAX);
+}
+
+void Emit(rbrown::RecompilerState& state, rbrown::EmitterX64& emitter, uint32_t opcode) {
+    using namespace rbrown;
+    switch (InstructionOp(opcode)) {
+        case 0x00: switch(InstructionFunction(opcode)) {
+            case 0x20: return EmitAdd(state, emitter, opcode);
+            case 0x21: return EmitAddu(emitter, opcode);
+            case 0x23: return EmitSubu(emitter, opcode);
+            default:
+                break;
+        }
+        default:
+            break;
+    }
+}
+
+}
+
+void Example11() {
+
+    using namespace rbrown;
+
+    // Two independent processors that will share the same compiled code
+    R3051 first;
+    first.WriteRegister(1, 100);
+    first.WriteRegister(2, 72);
+    first.WriteRegister(4, 99);
+    first.WriteRegister(5, 77);
+
+    R3051 second;
+    second.WriteRegister(1, 0x40000000u);
+    second.WriteRegister(2, 0x40000000u);
+    second.WriteRegister(4, 7);
+    second.WriteRegister(5, 3);
+
+    HelperTable helpers;
+    RecompilerState state(0x80010000u);
+    CodeBuffer buffer(1024);
+
+    // Prologue
+    EmitterX64 emitter(buffer);
+    EmitBlockPrologue(emitter);
+
+    // Instructions
+    // ADDU $3, $1, $2
+    // SUBU $6, $4, $5
+    // ADD  $7, $1, $2
+    for (const uint32_t opcode : { 0x00221821u, 0x00853023u, 0x00223820u }) {
+        Emit(state, emitter, opcode);
+        state.SetPC(state.GetPC() + 4u);
+    }
+
+    // Epilogue
+    EmitStorePC(emitter, state.GetPC());
+    EmitBlockEpilogue(emitter);
+
+    buffer.Protect();
+
+    // The same block runs against both processors
+    // the second of which takes an arithmetic overflow exception
+    const CompiledBlock block = BlockAt(buffer, 0u);
+    block(&first, helpers.Entries());
+    block(&second, helpers.Entries());
+
+}
@@ -0,0 +1,129 @@
+#include "BlockAbi.h"
+#include "CodeCache.h"
+#include "EmitterX64.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "X64.h"
+#include "MIPS.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t MAX_BLOCK_INSTRUCTIONS = 32u;
+constexpr size_t RAM_SIZE = 0x200000u;
+
+void EmitAddu(rbrown::EmitterX64& emitter, uint32_t opcode) {
+    // Rd = Rs + Rt
+    using namespace rbrown;
+    EmitLoadGuestRegister(emitter, RAX, InstructionRs(opcode));
+    EmitLoadGuestRegister(emitter, RCX, InstructionRt(opcode));
+    emitter.AddR32R32(RAX, RCX);
+    EmitStoreGuestRegister(emitter, InstructionRd(opcode), RAX);
+}
+
+void EmitAddiu(rbrown::EmitterX64& emitter, uint32_t opcode) {
+    // Rt = Rs + Immediate
+    using namespace rbrown;
+    EmitLoadGuestRegister(emitter, RAX, InstructionRs(opcode));
+    emitter.AddR32Imm32(RAX, InstructionImmediateExtended(opcode));
+    EmitStoreGuestRegister(emitter, InstructionRt(opcode), RAX);
+}
+
+bool Emit(rbrown::EmitterX64& emitter, uint32_t opcode) {
+    using namespace rbrown;
+    switch (InstructionOp(opcode)) {
+        case 0x00: switch(InstructionFunction(opcode)) {
+            case 0x21: EmitAddu(emitter, opcode); return true;
+            default:
+                break;
+        }
+        break;
+        case 0x09: EmitAddiu(emitter, opcode); return true;
+        default:
+            break;
+    }
+    return false;
+}
+
+uint32_t CompileBlock(rbrown::EmitterX64& emitter, const rbrown::Memory& memory, uint32_t start) {
+    // Compile straight line code up to and including the delay slot of a J
+    using namespace rbrown;
+    EmitBlockPrologue(emitter);
+    uint32_t pc = start;
+    uint32_t next = start;
+    for (uint32_t i = 0u; i < MAX_BLOCK_INSTRUCTIONS; ++i) {
+        const uint32_t opcode = memory.ReadWord(pc);
+        if (InstructionOp(opcode) == 0x02u) {
+            Emit(emitter, memory.ReadWord(pc + 4u));
+            next = ((pc + 4u) & 0xF0000000u) + ((opcode & 0x03FFFFFFu) << 2u);
+            pc += 8u;
+            break;
+        }
+        Emit(emitter, opcode);
+        pc += 4u;
+        next = pc;
+    }
+    EmitStorePC(emitter, next);
+    EmitBlockEpilogue(emitter);
+    return (pc - start) / 4u;
+}
+
+void LoadProgram(rbrown::Memory& memory, uint32_t increment) {
+    // loop: ADDIU $1, $1, increment
+    //       ADDU  $2, $2, $1
+    //       J     loop
+    //       NOP
+    memory.WriteWord(PROGRAM_START + 0u, 0x24210000u + increment);
+    memory.WriteWord(PROGRAM_START + 4u, 0x00411021u);
+    memory.WriteWord(PROGRAM_START + 8u, 0x08000000u + ((PROGRAM_START & 0x0FFFFFFFu) >> 2u));
+    memory.WriteWord(PROGRAM_START + 12u, 0x00000000u);
+}
+
+}
+
+void Example12() {
+
+    using namespace rbrown;
+
+    constexpr uint32_t INSTANCES = 16u;
+    constexpr uint32_t WORKERS = 4u;
+    constexpr uint32_t BLOCKS_PER_SLICE = 1000u;
+
+    // One code cache for every instance
+    CodeCache cache(0x10000u, CompileBlock);
+
+    // Two different programs live at the same address, half the instances run each one
+    std::vector<std::unique_ptr<Instance>> instances;
+    for (uint32_t i = 0u; i < INSTANCES; ++i) {
+        auto instance = std::make_unique<Instance>(cache, RAM_SIZE);
+        LoadProgram(instance->Ram(), 1u + (i & 1u));
+        instance->Processor().WritePC(PROGRAM_START);
+        instances.push_back(std::move(instance));
+    }
+
+    // Workers take instances from a shared queue until there are none left
+    std::atomic<uint32_t> nextInstance { 0u };
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0u; i < WORKERS; ++i) {
+        workers.emplace_back([&]() {
+            for (uint32_t n = nextInstance++; n < INSTANCES; n = nextInstance++) {
+                instances[n]->Run(BLOCKS_PER_SLICE);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // The first instance rewrites its program so it only needs its own blocks invalidating
+    Instance& first = *instances.front();
+    LoadProgram(first.Ram(), 3u);
+    first.Invalidate(PROGRAM_START, 16u);
+    first.Run(BLOCKS_PER_SLICE);
+
+}
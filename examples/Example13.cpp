@@ -0,0 +1,82 @@
+#include "Lockstep.h"
+#include "MIPS.h"
+
+#include <initializer_list>
+
+namespace {
+
+void InterpretScalar(rbrown::R3051& processor, uint32_t opcode) {
+    using namespace rbrown;
+    switch (InstructionOp(opcode)) {
+        case 0x00: switch(InstructionFunction(opcode)) {
+            case 0x20: return InterpretAdd(&processor, opcode);
+            case 0x21: return InterpretAddu(&processor, opcode);
+            case 0x23: return InterpretSubu(&processor, opcode);
+            default:
+                break;
+        }
+        break;
+        case 0x09: return InterpretAddiu(&processor, opcode);
+        default:
+            break;
+    }
+}
+
+uint32_t InterpretLockstep(rbrown::LockstepBatch& batch, uint32_t opcode) {
+    // Returns the lanes that could not follow the batch
+    using namespace rbrown;
+    switch (InstructionOp(opcode)) {
+        case 0x00: switch(InstructionFunction(opcode)) {
+            case 0x20: return LockstepAdd(&batch, opcode);
+            case 0x21: LockstepAddu(&batch, opcode); return 0u;
+            case 0x23: LockstepSubu(&batch, opcode); return 0u;
+            default:
+                break;
+        }
+        break;
+        case 0x09: LockstepAddiu(&batch, opcode); return 0u;
+        default:
+            break;
+    }
+    // Anything we can't vectorise runs on the scalar interpreter for every lane
+    return batch.ActiveLanes();
+}
+
+}
+
+void Example13() {
+
+    using namespace rbrown;
+
+    // A batch of processors that only differ in their inputs
+    R3051 processors[LOCKSTEP_LANES];
+    R3051* lanes[LOCKSTEP_LANES];
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; ++i) {
+        processors[i].WriteRegister(1, i * 0x10000000u);
+        processors[i].WriteRegister(2, 0x40000000u);
+        lanes[i] = &processors[i];
+    }
+
+    LockstepBatch batch;
+    batch.Gather(lanes, LOCKSTEP_LANES);
+
+    // Instructions
+    // ADDIU $1, $1, 5
+    // ADDU  $3, $1, $2
+    // SUBU  $4, $3, $1
+    // ADD   $5, $3, $2 : overflows in some lanes
+    // ADDIU $6, $5, 1
+    for (const uint32_t opcode : { 0x24210005u, 0x00221821u, 0x00612023u, 0x00622820u, 0x24a60001u }) {
+        uint32_t diverged = InterpretLockstep(batch, opcode);
+        // Lanes that diverged leave the batch and execute this instruction on their own
+        for (uint32_t lane = 0u; diverged; ++lane, diverged >>= 1u) {
+            if (diverged & 1u) {
+                batch.Diverge(lane);
+                InterpretScalar(*batch.Lane(lane), opcode);
+            }
+        }
+    }
+
+    batch.Scatter();
+
+}
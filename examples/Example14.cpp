@@ -0,0 +1,65 @@
+#include "Memory.h"
+#include "MIPS.h"
+#include "PredecodedInterpreter.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t SOURCE = 0x80020000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+
+void LoadProgram(rbrown::Memory& memory, uint32_t count) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c048002u,            //           LUI   $4, 0x8002
+            0x3c058003u,            //           LUI   $5, 0x8003
+            0x24060000u + count,    //           ADDIU $6, $0, count
+            0x8c870000u,            // loop:     LW    $7, 0($4)
+            0x24840004u,            //           ADDIU $4, $4, 4
+            0xaca70000u,            //           SW    $7, 0($5)
+            0x24a50004u,            //           ADDIU $5, $5, 4
+            0x24c6ffffu,            //           ADDIU $6, $6, -1
+            0x14c0fffau,            //           BNE   $6, $0, loop
+            0x01074021u,            //           ADDU  $8, $8, $7
+            0x0c00400eu,            //           JAL   function
+            0x00000000u,            //           NOP
+            0x0800400cu,            // done:     J     done
+            0x00000000u,            //           NOP
+            0x25290001u,            // function: ADDIU $9, $9, 1
+            0x03e00008u,            //           JR    $31
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example14() {
+
+    using namespace rbrown;
+
+    Memory memory(RAM_SIZE);
+    for (uint32_t i = 0u; i < 16u; ++i) {
+        memory.WriteWord(SOURCE + 4u * i, i + 1u);
+    }
+    LoadProgram(memory, 16u);
+
+    R3051 processor;
+    processor.AttachMemory(&memory);
+    processor.WritePC(PROGRAM_START);
+
+    // Each page is decoded the first time it's executed
+    PredecodedInterpreter interpreter(processor);
+    interpreter.Run(1000u);
+
+    // Rewriting the program means the decoded page must be thrown away
+    LoadProgram(memory, 8u);
+    interpreter.Invalidate(PROGRAM_START, 17u * 4u);
+    processor.WritePC(PROGRAM_START);
+    interpreter.Run(1000u);
+
+}
@@ -0,0 +1,78 @@
+#include "MIPS.h"
+#include "SpecializedInterpreter.h"
+
+#include <chrono>
+#include <initializer_list>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t ITERATIONS = 1000000u;
+
+void Interpret(rbrown::R3051& processor, uint32_t opcode) {
+    using namespace rbrown;
+    switch (InstructionOp(opcode)) {
+        case 0x00: switch(InstructionFunction(opcode)) {
+            case 0x21: return InterpretAddu(&processor, opcode);
+            case 0x23: return InterpretSubu(&processor, opcode);
+            default:
+                break;
+        }
+        break;
+        case 0x09: return InterpretAddiu(&processor, opcode);
+        default:
+            break;
+    }
+}
+
+template<typename F>
+double Measure(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+}
+
+void Example15() {
+
+    using namespace rbrown;
+
+    // Instructions
+    // ADDIU $1, $1, 1
+    // ADDU  $2, $2, $1
+    // SUBU  $3, $2, $1
+    // ADDIU $4, $3, -7
+    const std::initializer_list<uint32_t> opcodes = { 0x24210001u, 0x00411021u, 0x00411823u, 0x2464fff9u };
+
+    // The existing interpreter extracts the fields from the opcode on every call
+    R3051 generic;
+    const double genericTime = Measure([&]() {
+        for (uint32_t i = 0u; i < ITERATIONS; ++i) {
+            for (const uint32_t opcode : opcodes) {
+                Interpret(generic, opcode);
+            }
+        }
+    });
+
+    // The specialised interpreter selects a handler once when decoding
+    R3051 specialized;
+    std::vector<SpecializedInstruction> decoded;
+    for (const uint32_t opcode : opcodes) {
+        decoded.push_back(Specialize(opcode));
+    }
+    uint32_t* registers = reinterpret_cast<uint32_t*>(specialized.RegisterAddress(0));
+    const double specializedTime = Measure([&]() {
+        for (uint32_t i = 0u; i < ITERATIONS; ++i) {
+            for (const SpecializedInstruction& instruction : decoded) {
+                instruction.handler(&specialized, registers, instruction.operand);
+            }
+        }
+    });
+
+    std::cout << "generic interpreter " << genericTime << "ms "
+              << "specialized interpreter " << specializedTime << "ms" << std::endl;
+
+}
@@ -0,0 +1,105 @@
+#include "BlockAbi.h"
+#include "CodeBuffer.h"
+#include "Decoder.h"
+#include "EmitterX64.h"
+#include "HelperTable.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "RecomilerState.h"
+
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t STRING = 0x80020000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c048002u,            // start:    LUI   $4, 0x8002
+            0x0c00400bu,            //           JAL   strlen
+            0x00000000u,            //           NOP
+            0x00408021u,            //           ADDU  $16, $2, $0
+            0x3c058002u,            //           LUI   $5, 0x8002
+            0x98a60001u,            //           LWR   $6, 1($5)
+            0x88a60004u,            //           LWL   $6, 4($5)
+            0x00000000u,            //           NOP
+            0x0206382au,            //           SLT   $7, $16, $6
+            0x08004009u,            // done:     J     done
+            0x00000000u,            //           NOP
+            0x00001021u,            // strlen:   ADDU  $2, $0, $0
+            0x90880000u,            // loop:     LBU   $8, 0($4)
+            0x00000000u,            //           NOP
+            0x11000003u,            //           BEQ   $8, $0, out
+            0x24840001u,            //           ADDIU $4, $4, 1
+            0x0800400cu,            //           J     loop
+            0x24420001u,            //           ADDIU $2, $2, 1
+            0x03e00008u,            // out:      JR    $31
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+void LoadString(rbrown::Memory& memory, const char* string) {
+    const size_t length = std::strlen(string);
+    for (size_t i = 0u; i <= length; ++i) {
+        memory.WriteByte(STRING + i, static_cast<uint8_t>(string[i]));
+    }
+}
+
+}
+
+void Example16() {
+
+    using namespace rbrown;
+
+    // The interpreter finds every instruction through the decode table
+    Memory memory(RAM_SIZE);
+    LoadProgram(memory);
+    LoadString(memory, "hello, world");
+
+    R3051 processor;
+    processor.AttachMemory(&memory);
+    processor.WritePC(PROGRAM_START);
+    Run(&processor, 200u);
+
+    // The recompiler uses the same table to find the native implementations
+    HelperTable helpers;
+    RecompilerState state(0u);
+    CodeBuffer buffer(1024);
+    EmitterX64 emitter(buffer);
+    EmitBlockPrologue(emitter);
+    for (const uint32_t opcode : {
+            0x3c011234u,            // LUI   $1, 0x1234
+            0x34215678u,            // ORI   $1, $1, 0x5678
+            0x00011202u,            // SRL   $2, $1, 8
+            0x00011903u,            // SRA   $3, $1, 4
+            0x2404fffdu,            // ADDIU $4, $0, -3
+            0x28850000u,            // SLTI  $5, $4, 0
+            0x2c860000u,            // SLTIU $6, $4, 0
+            0x30270ff0u,            // ANDI  $7, $1, 0xff0
+            0x00224027u,            // NOR   $8, $1, $2
+            0x00a14804u,            // SLLV  $9, $1, $5
+            0x01095026u,            // XOR   $10, $8, $9
+            0x01445822u,            // SUB   $11, $10, $4
+        }) {
+        const InstructionInfo& info = DecodeInstruction(opcode);
+        if (info.emit) {
+            info.emit(state, emitter, opcode);
+        }
+        state.SetPC(state.GetPC() + 4u);
+    }
+    EmitStorePC(emitter, state.GetPC());
+    EmitBlockEpilogue(emitter);
+    buffer.Protect();
+
+    R3051 compiled;
+    BlockAt(buffer, 0u)(&compiled, helpers.Entries());
+
+}
@@ -0,0 +1,77 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t STRING = 0x80020000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c048002u,            // start:    LUI   $4, 0x8002
+            0x0c00400au,            //           JAL   strlen
+            0x00000000u,            //           NOP
+            0x00408021u,            //           ADDU  $16, $2, $0
+            0x3c058002u,            //           LUI   $5, 0x8002
+            0x8ca90000u,            //           LW    $9, 0($5)
+            0x01205021u,            //           ADDU  $10, $9, $0
+            0x01205821u,            //           ADDU  $11, $9, $0
+            0x08004008u,            // done:     J     done
+            0x00000000u,            //           NOP
+            0x00001021u,            // strlen:   ADDU  $2, $0, $0
+            0x90880000u,            // loop:     LBU   $8, 0($4)
+            0x00000000u,            //           NOP
+            0x11000003u,            //           BEQ   $8, $0, out
+            0x24840001u,            //           ADDIU $4, $4, 1
+            0x0800400bu,            //           J     loop
+            0x24420001u,            //           ADDIU $2, $2, 1
+            0x03e00008u,            // out:      JR    $31
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+void LoadString(rbrown::Memory& memory, const char* string) {
+    const size_t length = std::strlen(string);
+    for (size_t i = 0u; i <= length; ++i) {
+        memory.WriteByte(STRING + i, static_cast<uint8_t>(string[i]));
+    }
+}
+
+}
+
+void Example17() {
+
+    using namespace rbrown;
+
+    // Loads, stores and branches have no native implementation yet
+    // so the compiled blocks call their interpreter functions instead
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    LoadString(instance.Ram(), "hello, world");
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(100u);
+
+    // The interpreter should arrive at the same state
+    Memory memory(RAM_SIZE);
+    LoadProgram(memory);
+    LoadString(memory, "hello, world");
+    R3051 processor;
+    processor.AttachMemory(&memory);
+    processor.WritePC(PROGRAM_START);
+    Run(&processor, 200u);
+
+}
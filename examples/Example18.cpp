@@ -0,0 +1,75 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c010001u,            // start:    LUI   $1, 0x0001
+            0x34218000u,            //           ORI   $1, $1, 0x8000
+            0x3c02fffdu,            //           LUI   $2, 0xfffd
+            0x3442c000u,            //           ORI   $2, $2, 0xc000
+            0x00220018u,            //           MULT  $1, $2
+            0x00001812u,            //           MFLO  $3
+            0x00002010u,            //           MFHI  $4
+            0x00031c02u,            //           SRL   $3, $3, 16
+            0x00042400u,            //           SLL   $4, $4, 16
+            0x00641825u,            //           OR    $3, $3, $4
+            0x00220019u,            //           MULTU $1, $2
+            0x00002810u,            //           MFHI  $5
+            0x0041001au,            //           DIV   $2, $1
+            0x00003012u,            //           MFLO  $6
+            0x00003810u,            //           MFHI  $7
+            0x0040001au,            //           DIV   $2, $0
+            0x00004012u,            //           MFLO  $8
+            0x00004810u,            //           MFHI  $9
+            0x3c0a8000u,            //           LUI   $10, 0x8000
+            0x240bffffu,            //           ADDIU $11, $0, -1
+            0x014b001au,            //           DIV   $10, $11
+            0x00006012u,            //           MFLO  $12
+            0x00006810u,            //           MFHI  $13
+            0x0020001bu,            //           DIVU  $1, $0
+            0x00200011u,            //           MTHI  $1
+            0x08004019u,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example18() {
+
+    using namespace rbrown;
+
+    // A 16.16 fixed point multiply 1.5 * -2.25 followed by division by zero
+    // and overflow, neither of which trap on MIPS
+    // HI and LO stay in host registers until the block ends
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(1u);
+
+    // The interpreter should arrive at the same state
+    Memory memory(RAM_SIZE);
+    LoadProgram(memory);
+    R3051 processor;
+    processor.AttachMemory(&memory);
+    processor.WritePC(PROGRAM_START);
+    Run(&processor, 27u);
+
+}
@@ -0,0 +1,100 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t VERTICES = 0x80020000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x24011000u,            // start:    ADDIU $1, $0, 0x1000
+            0x48c10000u,            //           CTC2  $1, $0
+            0x48c00800u,            //           CTC2  $0, $1
+            0x48c11000u,            //           CTC2  $1, $2
+            0x48c01800u,            //           CTC2  $0, $3
+            0x48c12000u,            //           CTC2  $1, $4
+            0x48c02800u,            //           CTC2  $0, $5
+            0x48c03000u,            //           CTC2  $0, $6
+            0x24020400u,            //           ADDIU $2, $0, 0x400
+            0x48c23800u,            //           CTC2  $2, $7
+            0x3c0300a0u,            //           LUI   $3, 160
+            0x48c3c000u,            //           CTC2  $3, $24
+            0x3c030078u,            //           LUI   $3, 120
+            0x48c3c800u,            //           CTC2  $3, $25
+            0x240400c8u,            //           ADDIU $4, $0, 200
+            0x48c4d000u,            //           CTC2  $4, $26
+            0x24050555u,            //           ADDIU $5, $0, 0x555
+            0x48c5e800u,            //           CTC2  $5, $29
+            0x3c068002u,            //           LUI   $6, 0x8002
+            0xc8c00000u,            //           LWC2  $0, 0($6)
+            0xc8c10004u,            //           LWC2  $1, 4($6)
+            0xc8c20008u,            //           LWC2  $2, 8($6)
+            0xc8c3000cu,            //           LWC2  $3, 12($6)
+            0xc8c40010u,            //           LWC2  $4, 16($6)
+            0xc8c50014u,            //           LWC2  $5, 20($6)
+            0x4a280030u,            //           RTPT
+            0x4b400006u,            //           NCLIP
+            0x480bc000u,            //           MFC2  $11, $24
+            0x4b58002du,            //           AVSZ3
+            0xe8cc0018u,            //           SWC2  $12, 24($6)
+            0x480c3800u,            //           MFC2  $12, $7
+            0xe8cd001cu,            //           SWC2  $13, 28($6)
+            0x484df800u,            //           CFC2  $13, $31
+            0xe8ce0020u,            //           SWC2  $14, 32($6)
+            0x08004022u,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+void LoadVertices(rbrown::Memory& memory) {
+    // Each vertex is VXY packed as two halfwords followed by VZ
+    uint32_t address = VERTICES;
+    for (const uint32_t word : {
+            0xffceff9cu, 0x00000000u,   // (-100, -50,   0)
+            0xffce0064u, 0x00000000u,   // ( 100, -50,   0)
+            0x00500000u, 0x000000c8u,   // (   0,  80, 200)
+        }) {
+        memory.WriteWord(address, word);
+        address += 4u;
+    }
+}
+
+}
+
+void Example19() {
+
+    using namespace rbrown;
+
+    // Project a triangle with RTPT then find its winding with NCLIP and its
+    // ordering table depth with AVSZ3
+    // The block calls each GTE command directly without going through the interpreter
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    LoadVertices(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(2u);
+
+    // The interpreter should arrive at the same state
+    Memory memory(RAM_SIZE);
+    LoadProgram(memory);
+    LoadVertices(memory);
+    R3051 processor;
+    processor.AttachMemory(&memory);
+    processor.WritePC(PROGRAM_START);
+    Run(&processor, 36u);
+
+}
@@ -32,6 +32,7 @@ void Example2() {
     emitter.Call(AddressOf(Add));
     emitter.AddR64Imm8(RSP, 8u);
     emitter.Ret();
+    emitter.EmitLiteralPool();
 
     buffer.Protect();
     buffer.Call();
@@ -0,0 +1,69 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+#include "Scheduler.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t VBLANK_FLAG = 0x80020000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+constexpr uint64_t VBLANK_CYCLES = 1000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c018002u,            // start:    LUI   $1, 0x8002
+            0x00001821u,            //           ADDU  $3, $0, $0
+            0x8c220000u,            // poll:     LW    $2, 0($1)
+            0x00000000u,            //           NOP
+            0x1040fffdu,            //           BEQ   $2, $0, poll
+            0x24630001u,            //           ADDIU $3, $3, 1
+            0xac200000u,            //           SW    $0, 0($1)
+            0x08004002u,            //           J     poll
+            0x24840001u,            //           ADDIU $4, $4, 1
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+struct VBlank {
+    rbrown::Scheduler& scheduler;
+    rbrown::Memory& memory;
+};
+
+void RaiseVBlank(void* context, uint64_t due) {
+    // Schedule the next one relative to when this one was due so lateness doesn't accumulate
+    // If that time has already gone it runs as soon as possible
+    auto* vblank = static_cast<VBlank*>(context);
+    vblank->memory.WriteWord(VBLANK_FLAG, 1u);
+    const uint64_t next = due + VBLANK_CYCLES;
+    const uint64_t now = vblank->scheduler.Now();
+    vblank->scheduler.Schedule(next > now ? next - now : 0u, RaiseVBlank, vblank);
+}
+
+}
+
+void Example20() {
+
+    using namespace rbrown;
+
+    // The guest polls a flag that a VBlank event sets every thousand cycles
+    // $3 counts polls and $4 counts frames, each poll loop costs five cycles
+    // so there should be about two hundred polls per frame
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+
+    VBlank vblank { instance.Events(), instance.Ram() };
+    instance.Events().Schedule(VBLANK_CYCLES, RaiseVBlank, &vblank);
+    instance.Run(2000u);
+
+}
@@ -0,0 +1,80 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+#include "Scheduler.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t HANDLER_START = 0xBFC00180u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+constexpr uint64_t TIMER_CYCLES = 100u;
+constexpr uint64_t PULSE_CYCLES = 4u;
+constexpr uint32_t TIMER_LINE = 0u;
+
+void LoadProgram(rbrown::Memory& memory, uint32_t address, const std::initializer_list<uint32_t>& opcodes) {
+    for (const uint32_t opcode : opcodes) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+void LoadPrograms(rbrown::Memory& memory) {
+    LoadProgram(memory, PROGRAM_START, {
+        0x34010401u,            // start:    ORI   $1, $0, 0x0401
+        0x40816000u,            //           MTC0  $1, $12
+        0x08004002u,            // loop:     J     loop
+        0x24a50001u,            //           ADDIU $5, $5, 1
+    });
+    LoadProgram(memory, HANDLER_START, {
+        0x24c60001u,            // handler:  ADDIU $6, $6, 1
+        0x401a7000u,            //           MFC0  $26, $14
+        0x00000000u,            //           NOP
+        0x03400008u,            //           JR    $26
+        0x42000010u,            //           RFE
+    });
+}
+
+struct Timer {
+    rbrown::Scheduler& scheduler;
+    rbrown::R3051& processor;
+};
+
+void EndPulse(void* context, uint64_t) {
+    auto* timer = static_cast<Timer*>(context);
+    timer->processor.DeassertInterrupt(TIMER_LINE);
+}
+
+void Tick(void* context, uint64_t due) {
+    // The line is held for a few cycles, long enough for the handler to be entered
+    auto* timer = static_cast<Timer*>(context);
+    timer->processor.AssertInterrupt(TIMER_LINE);
+    timer->scheduler.Schedule(PULSE_CYCLES, EndPulse, timer);
+    timer->scheduler.Schedule(due + TIMER_CYCLES - timer->scheduler.Now(), Tick, timer);
+}
+
+}
+
+void Example21() {
+
+    using namespace rbrown;
+
+    // The guest enables the timer interrupt and spins, counting in $5
+    // Each interrupt runs the handler which counts in $6 and returns to the loop
+    // Asserting the line only sets the exit request, the interrupt is taken by
+    // the dispatcher between blocks
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance instance(cache, RAM_SIZE);
+    LoadPrograms(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+
+    Timer timer { instance.Events(), instance.Processor() };
+    instance.Events().Schedule(TIMER_CYCLES, Tick, &timer);
+    instance.Run(1000u);
+
+}
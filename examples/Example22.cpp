@@ -0,0 +1,71 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t TABLE = 0x80020000u;
+constexpr uint32_t TABLE_LENGTH = 16u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x34010064u,            // start:    ORI   $1, $0, 100
+            0x00001021u,            //           ADDU  $2, $0, $0
+            0x2421ffffu,            // mix:      ADDIU $1, $1, -1
+            0x00411021u,            //           ADDU  $2, $2, $1
+            0x000218c0u,            //           SLL   $3, $2, 3
+            0x1420fffcu,            //           BNE   $1, $0, mix
+            0x00431026u,            //           XOR   $2, $2, $3
+            0x3c048002u,            //           LUI   $4, 0x8002
+            0x34050010u,            //           ORI   $5, $0, 16
+            0x8c860000u,            // sum:      LW    $6, 0($4)
+            0x24a5ffffu,            //           ADDIU $5, $5, -1
+            0x00e63821u,            //           ADDU  $7, $7, $6
+            0x1ca0fffcu,            //           BGTZ  $5, sum
+            0x24840004u,            //           ADDIU $4, $4, 4
+            0x0800400eu,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+    for (uint32_t i = 0u; i < TABLE_LENGTH; ++i) {
+        memory.WriteWord(TABLE + 4u * i, i * i);
+    }
+}
+
+}
+
+void Example22() {
+
+    using namespace rbrown;
+
+    // Both loops branch back into the block they end, so after the first
+    // iteration the block jumps straight back instead of returning to the dispatcher
+    // The first loop is only arithmetic and keeps its registers in host registers
+    // until it finishes, the second loads from memory and goes through the
+    // processor's registers on every iteration
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance compiled(cache, RAM_SIZE);
+    LoadProgram(compiled.Ram());
+    compiled.Processor().WritePC(PROGRAM_START);
+    compiled.Run(100u);
+
+    // The interpreter gets to the same registers one instruction at a time
+    Memory memory(RAM_SIZE);
+    LoadProgram(memory);
+    R3051 interpreted;
+    interpreted.AttachMemory(&memory);
+    interpreted.WritePC(PROGRAM_START);
+    Run(&interpreted, 1000u);
+
+}
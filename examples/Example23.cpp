@@ -0,0 +1,65 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+#include "Scheduler.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t VBLANK_FLAG = 0x80020000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+constexpr uint64_t VBLANK_CYCLES = 1000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c018002u,            // start:    LUI   $1, 0x8002
+            0x8c220000u,            // wait:     LW    $2, 0($1)
+            0x00000000u,            //           NOP
+            0x1040fffdu,            //           BEQ   $2, $0, wait
+            0x00000000u,            //           NOP
+            0xac200000u,            //           SW    $0, 0($1)
+            0x08004001u,            //           J     wait
+            0x24840001u,            //           ADDIU $4, $4, 1
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+struct VBlank {
+    rbrown::Scheduler& scheduler;
+    rbrown::Memory& memory;
+};
+
+void RaiseVBlank(void* context, uint64_t due) {
+    auto* vblank = static_cast<VBlank*>(context);
+    vblank->memory.WriteWord(VBLANK_FLAG, 1u);
+    vblank->scheduler.Schedule(due + VBLANK_CYCLES - vblank->scheduler.Now(), RaiseVBlank, vblank);
+}
+
+}
+
+void Example23() {
+
+    using namespace rbrown;
+
+    // The same VBlank wait as before but the poll loop only loads, compares and branches
+    // The recompiler sees that nothing it reads can change until an event runs so
+    // instead of spinning it gives up the rest of the slice, the guest's clock
+    // jumps straight to the next VBlank and each frame takes a few dispatches
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+
+    VBlank vblank { instance.Events(), instance.Ram() };
+    instance.Events().Schedule(VBLANK_CYCLES, RaiseVBlank, &vblank);
+    instance.Run(2000u);
+
+}
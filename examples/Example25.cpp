@@ -0,0 +1,66 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x341000c8u,            // start:    ORI   $16, $0, 200
+            0x0c00400cu,            // loop:     JAL   square
+            0x02002021u,            //           ADDU  $4, $16, $0
+            0x02228821u,            //           ADDU  $17, $17, $2
+            0x0c004010u,            //           JAL   negate
+            0x00402021u,            //           ADDU  $4, $2, $0
+            0x02429021u,            //           ADDU  $18, $18, $2
+            0x2610ffffu,            //           ADDIU $16, $16, -1
+            0x1600fff8u,            //           BNE   $16, $0, loop
+            0x00000000u,            //           NOP
+            0x0800400au,            // done:     J     done
+            0x00000000u,            //           NOP
+            0x00840019u,            // square:   MULTU $4, $4
+            0x00001012u,            //           MFLO  $2
+            0x03e00008u,            //           JR    $31
+            0x00000000u,            //           NOP
+            0x03e00008u,            // negate:   JR    $31
+            0x00041023u,            //           SUBU  $2, $0, $4
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example25() {
+
+    using namespace rbrown;
+
+    // Each iteration makes two calls and both functions return with JR $31
+    // The calls push where they return to on the instance's return stack and the
+    // returns pop it, so once every block has been seen the dispatcher goes from
+    // block to block without looking any of them up
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance compiled(cache, RAM_SIZE);
+    LoadProgram(compiled.Ram());
+    compiled.Processor().WritePC(PROGRAM_START);
+    compiled.Run(1500u);
+
+    Memory memory(RAM_SIZE);
+    LoadProgram(memory);
+    R3051 interpreted;
+    interpreted.AttachMemory(&memory);
+    interpreted.WritePC(PROGRAM_START);
+    Run(&interpreted, 5000u);
+
+}
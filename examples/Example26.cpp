@@ -0,0 +1,73 @@
+#include "Bios.h"
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t STRING = 0x80020000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c048002u,            // start:    LUI   $4, 0x8002
+            0x0c00400eu,            //           JAL   strlen
+            0x00000000u,            //           NOP
+            0x00408021u,            //           ADDU  $16, $2, $0
+            0x3c048003u,            //           LUI   $4, 0x8003
+            0x3c058002u,            //           LUI   $5, 0x8002
+            0x0c004011u,            //           JAL   memcpy
+            0x02003021u,            //           ADDU  $6, $16, $0
+            0x34040001u,            //           ORI   $4, $0, 1
+            0x3c058003u,            //           LUI   $5, 0x8003
+            0x0c004014u,            //           JAL   write
+            0x02003021u,            //           ADDU  $6, $16, $0
+            0x0800400cu,            // done:     J     done
+            0x00000000u,            //           NOP
+            0x240a00a0u,            // strlen:   ADDIU $10, $0, 0xA0
+            0x01400008u,            //           JR    $10
+            0x2409001bu,            //           ADDIU $9, $0, 0x1B
+            0x240a00a0u,            // memcpy:   ADDIU $10, $0, 0xA0
+            0x01400008u,            //           JR    $10
+            0x2409002au,            //           ADDIU $9, $0, 0x2A
+            0x240a00b0u,            // write:    ADDIU $10, $0, 0xB0
+            0x01400008u,            //           JR    $10
+            0x24090035u,            //           ADDIU $9, $0, 0x35
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+void LoadString(rbrown::Memory& memory, const char* string) {
+    const size_t length = std::strlen(string);
+    for (size_t i = 0u; i <= length; ++i) {
+        memory.WriteByte(STRING + i, static_cast<uint8_t>(string[i]));
+    }
+}
+
+}
+
+void Example26() {
+
+    using namespace rbrown;
+
+    // The guest calls strlen, memcpy and write through the usual BIOS stubs
+    // There is no BIOS loaded, the blocks at 0xA0 and 0xB0 call the native versions
+    // and return to $31, and write to the TTY ends up on the HLE console
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    LoadString(instance.Ram(), "hello, world\n");
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(20u);
+
+}
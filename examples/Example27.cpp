@@ -0,0 +1,55 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "PerfMap.h"
+#include "Recompiler.h"
+
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x340103e8u,            // start:    ORI   $1, $0, 1000
+            0x3022000fu,            // loop:     ANDI  $2, $1, 15
+            0x00210018u,            //           MULT  $1, $1
+            0x14400002u,            //           BNE   $2, $0, skip
+            0x00000000u,            //           NOP
+            0x24840001u,            //           ADDIU $4, $4, 1
+            0x00002812u,            // skip:     MFLO  $5
+            0x2421ffffu,            //           ADDIU $1, $1, -1
+            0x00c53021u,            //           ADDU  $6, $6, $5
+            0x1420fff7u,            //           BNE   $1, $0, loop
+            0x00000000u,            //           NOP
+            0x0800400bu,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example27() {
+
+    using namespace rbrown;
+
+    // Every block and trace compiled while the perf map is attached is named after its guest PC
+    // Run under perf record -k 1 and the samples in the code buffer show up as
+    // mips_blk_80010004 or mips_trace_80010004 instead of unknown addresses
+    PerfMap perfMap(true);
+    CodeCache cache(CACHE_SIZE, Recompile, RecompileTrace);
+    cache.AttachPerfMap(&perfMap);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(3000u);
+
+}
@@ -0,0 +1,60 @@
+#include "BlockProfiler.h"
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <initializer_list>
+#include <string>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x340101f4u,            // start:    ORI   $1, $0, 500
+            0x0c004008u,            // outer:    JAL   work
+            0x00000000u,            //           NOP
+            0x2421ffffu,            //           ADDIU $1, $1, -1
+            0x1420fffcu,            //           BNE   $1, $0, outer
+            0x00000000u,            //           NOP
+            0x08004006u,            // done:     J     done
+            0x00000000u,            //           NOP
+            0x34020008u,            // work:     ORI   $2, $0, 8
+            0x00621821u,            // inner:    ADDU  $3, $3, $2
+            0x2442ffffu,            //           ADDIU $2, $2, -1
+            0x1440fffdu,            //           BNE   $2, $0, inner
+            0x00000000u,            //           NOP
+            0x24840001u,            //           ADDIU $4, $4, 1
+            0x03e00008u,            //           JR    $31
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example29() {
+
+    using namespace rbrown;
+
+    // Blocks compiled while the profiler is attached count their own entries
+    // and, since timing is on, the host cycles spent in them
+    // The report lists the hottest blocks and traces with their guest code
+    BlockProfiler profiler(true);
+    CodeCache cache(CACHE_SIZE, Recompile, RecompileTrace);
+    cache.AttachProfiler(&profiler);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(3000u);
+    const std::string report = profiler.Report(instance.Ram(), 4u);
+
+}
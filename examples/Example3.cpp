@@ -69,6 +69,7 @@ void Example3() {
     emitter.MovR64R64(RSP, RBP);
     emitter.PopR64(RBP);
     emitter.Ret();
+    emitter.EmitLiteralPool();
 
     buffer.Protect();
     buffer.Call();
@@ -0,0 +1,75 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "JitStats.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <cassert>
+#include <initializer_list>
+#include <string>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c018002u,            // start:    LUI   $1, 0x8002
+            0x34020040u,            //           ORI   $2, $0, 64
+            0xac220000u,            // fill:     SW    $2, 0($1)
+            0x24210004u,            //           ADDIU $1, $1, 4
+            0x2442ffffu,            //           ADDIU $2, $2, -1
+            0x1440fffcu,            //           BNE   $2, $0, fill
+            0x00000000u,            //           NOP
+            0x3c018002u,            //           LUI   $1, 0x8002
+            0x34020040u,            //           ORI   $2, $0, 64
+            0x8c230000u,            // sum:      LW    $3, 0($1)
+            0x24210004u,            //           ADDIU $1, $1, 4
+            0x2442ffffu,            //           ADDIU $2, $2, -1
+            0x00832021u,            //           ADDU  $4, $4, $3
+            0x1440fffbu,            //           BNE   $2, $0, sum
+            0x00000000u,            //           NOP
+            0x00840018u,            //           MULT  $4, $4
+            0x00002812u,            //           MFLO  $5
+            0x08004011u,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example30() {
+
+    using namespace rbrown;
+
+    // Every compile records what it emitted and how long it took
+    // The stores and loads here have no native emitter so they show up as
+    // fallbacks, each costing a helper call and a good many host bytes
+    JitStats stats(0u);
+    CodeCache cache(CACHE_SIZE, Recompile, RecompileTrace);
+    cache.AttachStats(&stats);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(3000u);
+    const JitHistogram bytes = stats.Histogram(JIT_STAT_BYTES_PER_INSTRUCTION);
+    const JitHistogram fallbacks = stats.Histogram(JIT_STAT_FALLBACKS);
+    const std::string report = stats.Report();
+
+    assert(instance.Processor().ReadRegister(5) == 2080u * 2080u);
+    assert(bytes.samples == stats.CompileCount() && bytes.samples != 0u);
+    assert(bytes.minimum != 0u && bytes.minimum <= bytes.maximum);
+    assert(fallbacks.total != 0u);
+    assert(!report.empty());
+    static_cast<void>(bytes);
+    static_cast<void>(fallbacks);
+    static_cast<void>(report);
+
+}
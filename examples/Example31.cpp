@@ -0,0 +1,81 @@
+#include "CodeCache.h"
+#include "HardwareCounters.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <cassert>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+constexpr uint32_t SLICE_COUNT = 20u;
+constexpr uint32_t SLICE_LENGTH = 200u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c018002u,            // start:    LUI   $1, 0x8002
+            0x34020100u,            //           ORI   $2, $0, 256
+            0xac220000u,            // fill:     SW    $2, 0($1)
+            0x24210004u,            //           ADDIU $1, $1, 4
+            0x2442ffffu,            //           ADDIU $2, $2, -1
+            0x1440fffcu,            //           BNE   $2, $0, fill
+            0x00000000u,            //           NOP
+            0x0c00400bu,            // again:    JAL   checksum
+            0x00000000u,            //           NOP
+            0x08004007u,            //           J     again
+            0x24a50001u,            //           ADDIU $5, $5, 1
+            0x3c018002u,            // checksum: LUI   $1, 0x8002
+            0x34020100u,            //           ORI   $2, $0, 256
+            0x34040000u,            //           ORI   $4, $0, 0
+            0x8c230000u,            // sum:      LW    $3, 0($1)
+            0x24210004u,            //           ADDIU $1, $1, 4
+            0x00832026u,            //           XOR   $4, $4, $3
+            0x2442ffffu,            //           ADDIU $2, $2, -1
+            0x1440fffbu,            //           BNE   $2, $0, sum
+            0x00000000u,            //           NOP
+            0x03e00008u,            //           JR    $31
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example31() {
+
+    using namespace rbrown;
+
+    // Each call to Run is one slice measured with the host's performance counters
+    // and charged to the range of guest code its blocks came from
+    // Counters the host won't give us, as in most virtual machines, read as zero
+    HardwareCounters counters;
+    CodeCache cache(CACHE_SIZE, Recompile, RecompileTrace);
+    Instance instance(cache, RAM_SIZE);
+    instance.AttachCounters(&counters);
+    LoadProgram(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+    for (uint32_t slice = 0u; slice < SLICE_COUNT; ++slice) {
+        instance.Run(SLICE_LENGTH);
+    }
+    const HardwareSample total = counters.Total();
+    const std::vector<HardwareRange> top = counters.TopRanges(HW_INSTRUCTIONS, 4u);
+
+    // Slices are charged to their ranges whether or not any counter could be opened
+    assert(!top.empty() && top.size() <= 4u);
+    assert(top.front().range.start >= PROGRAM_START && top.front().range.start < top.front().range.end);
+    assert(counters.Available(HW_INSTRUCTIONS) || total.values[HW_INSTRUCTIONS] == 0u);
+    assert(!counters.Report(4u).empty());
+    static_cast<void>(total);
+    static_cast<void>(top);
+
+}
@@ -0,0 +1,60 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Mmap.h"
+#include "Recompiler.h"
+
+#include <cassert>
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x400000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c018010u,            // start:    LUI   $1, 0x8010
+            0x34020400u,            //           ORI   $2, $0, 1024
+            0xac220000u,            // fill:     SW    $2, 0($1)
+            0x24210400u,            //           ADDIU $1, $1, 1024
+            0x2442ffffu,            //           ADDIU $2, $2, -1
+            0x1440fffcu,            //           BNE   $2, $0, fill
+            0x00621821u,            //           ADDU  $3, $3, $2
+            0x08004007u,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example32() {
+
+    using namespace rbrown;
+
+    // Both the code cache and guest RAM ask for 2 MiB pages
+    // Each falls back from hugetlb to transparent huge pages to small pages
+    // and says which it ended up with
+    CodeCache cache(CACHE_SIZE, Recompile, RecompileTrace, true);
+    Instance instance(cache, RAM_SIZE, true);
+    LoadProgram(instance.Ram());
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(3000u);
+    const uint32_t cachePages = cache.PageMode();
+    const uint32_t ramPages = instance.Ram().PageMode();
+
+    // Whatever backing they got, the program runs the same
+    assert(cachePages == xmmap::PAGES_SMALL || cachePages == xmmap::PAGES_HUGETLB || cachePages == xmmap::PAGES_TRANSPARENT);
+    assert(ramPages == xmmap::PAGES_SMALL || ramPages == xmmap::PAGES_HUGETLB || ramPages == xmmap::PAGES_TRANSPARENT);
+    assert(instance.Ram().ReadWord(0x80100000u) == 1024u);
+    assert(instance.Ram().ReadWord(0x80100400u) == 1023u);
+    static_cast<void>(cachePages);
+    static_cast<void>(ramPages);
+
+}
@@ -0,0 +1,94 @@
+#include "CodeBuffer.h"
+#include "EmitterX64.h"
+#include "X64.h"
+#include "MIPS.h"
+
+#include <cassert>
+#include <initializer_list>
+
+namespace {
+
+void CallInterpreterFunction(
+        rbrown::EmitterX64 &emitter,
+        uintptr_t function,
+        rbrown::R3051 &processor,
+        uint32_t opcode) {
+    using namespace rbrown;
+    emitter.MovR64Imm64(RDI, AddressOf(processor));
+    emitter.MovR32Imm32(RSI, opcode);
+    emitter.Call(function);
+}
+
+void CallInterpreterFunctionPooled(
+        rbrown::EmitterX64 &emitter,
+        uintptr_t function,
+        rbrown::R3051 &processor,
+        uint32_t opcode) {
+    using namespace rbrown;
+    emitter.MovR64Literal(RDI, AddressOf(processor));
+    emitter.MovR32Imm32(RSI, opcode);
+    emitter.Call(function);
+}
+
+using CallEmitter = void (*)(rbrown::EmitterX64&, uintptr_t, rbrown::R3051&, uint32_t);
+
+void EmitProgram(rbrown::EmitterX64& emitter, rbrown::R3051& processor, CallEmitter call) {
+    using namespace rbrown;
+    // Prologue
+    emitter.PushR64(RBP);
+    emitter.MovR64R64(RBP, RSP);
+    // Instructions
+    // ADDU $3, $1, $2
+    // SUBU $6, $4, $5
+    // ADDU $7, $3, $6
+    // SUBU $8, $7, $1
+    // ADDU $9, $8, $8
+    // SUBU $10, $9, $2
+    // ADDU $11, $10, $4
+    // SUBU $12, $11, $5
+    for (const uint32_t opcode : { 0x00221821u, 0x00853023u, 0x00663821u, 0x00e14023u,
+                                   0x01084821u, 0x01225023u, 0x01445821u, 0x01656023u }) {
+        const uintptr_t function = InstructionFunction(opcode) == 0x21u ? AddressOf(InterpretAddu) : AddressOf(InterpretSubu);
+        call(emitter, function, processor, opcode);
+    }
+    // Epilogue
+    emitter.MovR64R64(RSP, RBP);
+    emitter.PopR64(RBP);
+    emitter.Ret();
+    emitter.EmitLiteralPool();
+}
+
+}
+
+void Example33() {
+
+    using namespace rbrown;
+
+    R3051 processor;
+    processor.WriteRegister(1, 100);
+    processor.WriteRegister(2, 72);
+    processor.WriteRegister(4, 99);
+    processor.WriteRegister(5, 77);
+
+    // Code like that of example 3 emitted twice
+    // Loading the processor's address from the literal pool takes 7 bytes rather than 10
+    // and the address itself is only stored once however many times it is loaded
+    CodeBuffer immediates(1024);
+    EmitterX64 immediateEmitter(immediates);
+    EmitProgram(immediateEmitter, processor, CallInterpreterFunction);
+
+    CodeBuffer pooled(1024);
+    EmitterX64 pooledEmitter(pooled);
+    EmitProgram(pooledEmitter, processor, CallInterpreterFunctionPooled);
+
+    const size_t immediateSize = immediates.Position();
+    const size_t pooledSize = pooled.Position();
+    assert(pooledSize < immediateSize);
+    static_cast<void>(immediateSize);
+    static_cast<void>(pooledSize);
+
+    pooled.Protect();
+    pooled.Call();
+    assert(processor.ReadRegister(12) == 138u);
+
+}
@@ -0,0 +1,46 @@
+#include "CodeBuffer.h"
+#include "EmitterX64.h"
+#include "X64.h"
+
+
+#include <cassert>
+#include <unistd.h>
+
+namespace {
+
+uint32_t Twice(uint32_t value) {
+    return 2u * value;
+}
+
+}
+
+void Example34() {
+
+    using namespace rbrown;
+
+    uint32_t result = 0u;
+
+    // The buffer is placed near the executable so the call to Twice is a plain rel32
+    // getpid is in the C library, usually mapped too far away for that, so the
+    // call goes through a veneer in the buffer's island that jumps the rest of the way
+    CodeBuffer buffer(1024);
+
+    EmitterX64 emitter(buffer);
+    emitter.SubR64Imm8(RSP, 8u);
+    emitter.Call(reinterpret_cast<uintptr_t>(&getpid));
+    emitter.MovR32R32(RDI, RAX);
+    emitter.Call(AddressOf(Twice));
+    emitter.MovR64Literal(RCX, AddressOf(result));
+    emitter.MovDisp8R32(RCX, 0u, RAX);
+    emitter.AddR64Imm8(RSP, 8u);
+    emitter.Ret();
+    emitter.EmitLiteralPool();
+
+    buffer.Protect();
+    buffer.Call();
+
+    // Only the call to getpid can have needed a veneer
+    assert(result == 2u * static_cast<uint32_t>(getpid()));
+    assert(buffer.VeneerCount() <= 1u);
+
+}
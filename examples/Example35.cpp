@@ -0,0 +1,74 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <cassert>
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t TABLE = 0x80020000u;
+constexpr uint32_t TABLE_LENGTH = 16u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c048002u,            // start:    LUI   $4, 0x8002
+            0x34890040u,            //           ORI   $9, $4, 0x40
+            0x34060001u,            //           ORI   $6, $0, 1
+            0x34079e37u,            //           ORI   $7, $0, 0x9E37
+            0x3408ffffu,            //           ORI   $8, $0, 0xFFFF
+            0xac860000u,            // fill:     SW    $6, 0($4)
+            0x00c73021u,            //           ADDU  $6, $6, $7
+            0x00c83024u,            //           AND   $6, $6, $8
+            0x24840004u,            //           ADDIU $4, $4, 4
+            0x1489fffbu,            //           BNE   $4, $9, fill
+            0x00000000u,            //           NOP
+            0x0800400bu,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example35() {
+
+    using namespace rbrown;
+
+    // The fill loop keeps all five of its registers in host registers and calls the
+    // interpreter for its store on every iteration. Only $4 and $6 change inside the loop
+    // so only they are written back before the call, $7, $8 and $9 already match the
+    // processor's copies and are just reloaded afterwards
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance compiled(cache, RAM_SIZE);
+    LoadProgram(compiled.Ram());
+    compiled.Processor().WritePC(PROGRAM_START);
+    compiled.Run(200u);
+
+    // The interpreter fills the same table one instruction at a time
+    Memory memory(RAM_SIZE);
+    LoadProgram(memory);
+    R3051 interpreted;
+    interpreted.AttachMemory(&memory);
+    interpreted.WritePC(PROGRAM_START);
+    Run(&interpreted, 200u);
+
+    uint32_t mismatches = 0u;
+    for (uint32_t i = 0u; i < TABLE_LENGTH; ++i) {
+        if (compiled.Ram().ReadWord(TABLE + 4u * i) != memory.ReadWord(TABLE + 4u * i)) {
+            ++mismatches;
+        }
+    }
+    assert(mismatches == 0u);
+    static_cast<void>(mismatches);
+
+}
@@ -0,0 +1,69 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t STRING = 0x80020000u;
+constexpr uint32_t ITERATIONS = 200u;
+constexpr uint32_t SUM_REGISTER = 16u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c048002u,            // start:    LUI   $4, 0x8002
+            0x340100c8u,            //           ORI   $1, $0, 200
+            0x0c00400au,            // loop:     JAL   strlen
+            0x00000000u,            //           NOP
+            0x02028021u,            //           ADDU  $16, $16, $2
+            0x2421ffffu,            //           ADDIU $1, $1, -1
+            0x1420fffbu,            //           BNE   $1, $0, loop
+            0x00000000u,            //           NOP
+            0x08004008u,            // done:     J     done
+            0x00000000u,            //           NOP
+            0x240a00a0u,            // strlen:   ADDIU $10, $0, 0xA0
+            0x01400008u,            //           JR    $10
+            0x2409001bu,            //           ADDIU $9, $0, 0x1B
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+void LoadString(rbrown::Memory& memory, const char* string) {
+    const size_t length = std::strlen(string);
+    for (size_t i = 0u; i <= length; ++i) {
+        memory.WriteByte(STRING + i, static_cast<uint8_t>(string[i]));
+    }
+}
+
+}
+
+void Example36() {
+
+    using namespace rbrown;
+
+    // Every edge of the loop through strlen gets hot, including the ones into and out of
+    // the BIOS vector at 0xA0. Only the block at the vector calls the native function so
+    // traces stop before it, and the sum comes out as if each call went through
+    const char* string = "hello, world\n";
+    CodeCache cache(CACHE_SIZE, Recompile, RecompileTrace);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    LoadString(instance.Ram(), string);
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(4u * ITERATIONS + 8u);
+
+    assert(instance.Processor().ReadRegister(SUM_REGISTER) == ITERATIONS * std::strlen(string));
+    assert(instance.TraceCount() != 0u);
+
+}
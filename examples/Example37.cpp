@@ -0,0 +1,81 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <cassert>
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t EXCEPTION_VECTOR = 0xBFC00180u;
+constexpr uint32_t BRANCH_PC = 0x80010014u;
+constexpr uint32_t CAUSE = 13u;
+constexpr uint32_t EPC = 14u;
+constexpr uint32_t CAUSE_BD = 0x80000000u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c048002u,            // start:    LUI   $4, 0x8002
+            0x34010064u,            //           ORI   $1, $0, 100
+            0x2421ffffu,            // loop:     ADDIU $1, $1, -1
+            0x2826005au,            //           SLTI  $6, $1, 90
+            0x00863821u,            //           ADDU  $7, $4, $6
+            0x1420fffcu,            //           BNE   $1, $0, loop
+            0xa4e00000u,            //           SH    $0, 0($7)
+            0x08004007u,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+    address = EXCEPTION_VECTOR;
+    for (const uint32_t opcode : {
+            0x0bf00060u,            // handler:  J     handler
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+}
+
+void Example37() {
+
+    using namespace rbrown;
+
+    // The store in the delay slot goes to an odd address from the eleventh iteration
+    // on, by which time the loop runs from its cached copy. The store is left to the
+    // interpreter which has to see that it is in a delay slot, so that the exception
+    // restarts at the branch with BD set just as it does when interpreted
+    // RAM repeats under the boot exception vector so the handler there just waits
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance compiled(cache, RAM_SIZE);
+    LoadProgram(compiled.Ram());
+    compiled.Processor().WritePC(PROGRAM_START);
+    compiled.Run(200u);
+
+    Memory memory(RAM_SIZE);
+    LoadProgram(memory);
+    R3051 interpreted;
+    interpreted.AttachMemory(&memory);
+    interpreted.WritePC(PROGRAM_START);
+    Run(&interpreted, 200u);
+
+    COP0& jit = compiled.Processor().Cop0();
+    COP0& reference = interpreted.Cop0();
+    assert(reference.ReadRegister(EPC) == BRANCH_PC && (reference.ReadRegister(CAUSE) & CAUSE_BD) != 0u);
+    assert(jit.ReadRegister(EPC) == reference.ReadRegister(EPC));
+    assert(jit.ReadRegister(CAUSE) == reference.ReadRegister(CAUSE));
+    assert(compiled.Processor().ReadPC() == EXCEPTION_VECTOR && interpreted.ReadPC() == EXCEPTION_VECTOR);
+    static_cast<void>(jit);
+    static_cast<void>(reference);
+
+}
@@ -0,0 +1,67 @@
+#include "CodeCache.h"
+#include "Instance.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "Recompiler.h"
+
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+constexpr uint32_t PROGRAM_START = 0x80010000u;
+constexpr uint32_t LONG_STRING = 0x80020000u;
+constexpr uint32_t SHORT_STRING = 0x80020010u;
+constexpr uint32_t POINTER = 0x80030000u;
+constexpr uint32_t RESULT_REGISTER = 16u;
+constexpr size_t RAM_SIZE = 0x200000u;
+constexpr size_t CACHE_SIZE = 0x10000u;
+
+void LoadProgram(rbrown::Memory& memory) {
+    uint32_t address = PROGRAM_START;
+    for (const uint32_t opcode : {
+            0x3c0b8003u,            // start:    LUI   $11, 0x8003
+            0x3c048002u,            //           LUI   $4, 0x8002
+            0x34840010u,            //           ORI   $4, $4, 0x10
+            0x240a00a0u,            //           ADDIU $10, $0, 0xA0
+            0x2409001bu,            //           ADDIU $9, $0, 0x1B
+            0x0140f809u,            //           JALR  $31, $10
+            0x8d640000u,            //           LW    $4, 0($11)
+            0x00408021u,            //           ADDU  $16, $2, $0
+            0x08004008u,            // done:     J     done
+            0x00000000u,            //           NOP
+        }) {
+        memory.WriteWord(address, opcode);
+        address += 4u;
+    }
+}
+
+void LoadString(rbrown::Memory& memory, uint32_t address, const char* string) {
+    const size_t length = std::strlen(string);
+    for (size_t i = 0u; i <= length; ++i) {
+        memory.WriteByte(address + i, static_cast<uint8_t>(string[i]));
+    }
+}
+
+}
+
+void Example38() {
+
+    using namespace rbrown;
+
+    // The string strlen is given is loaded in the delay slot of the jump to 0xA0
+    // The load is still pending when the block at the vector is entered, so it is
+    // written back before the native function reads its arguments from $4 on
+    CodeCache cache(CACHE_SIZE, Recompile);
+    Instance instance(cache, RAM_SIZE);
+    LoadProgram(instance.Ram());
+    LoadString(instance.Ram(), LONG_STRING, "hello");
+    LoadString(instance.Ram(), SHORT_STRING, "hi");
+    instance.Ram().WriteWord(POINTER, LONG_STRING);
+    instance.Processor().WritePC(PROGRAM_START);
+    instance.Run(8u);
+
+    assert(instance.Processor().ReadRegister(RESULT_REGISTER) == std::strlen("hello"));
+
+}
@@ -77,6 +77,7 @@ void Example4() {
     emitter.MovR64R64(RSP, RBP);
     emitter.PopR64(RBP);
     emitter.Ret();
+    emitter.EmitLiteralPool();
 
     buffer.Protect();
     buffer.Call();
@@ -76,6 +76,7 @@ void Example5() {
     emitter.MovR64R64(RSP, RBP);
     emitter.PopR64(RBP);
     emitter.Ret();
+    emitter.EmitLiteralPool();
 
     buffer.Protect();
     buffer.Call();
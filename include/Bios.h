@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rbrown {
+
+class R3051;
+
+// The BIOS is called through three tables by jumping to one of these with
+// the function number in $9, arguments in $4 to $7 and the return address in $31
+constexpr uint32_t BIOS_A0 = 0xA0u;
+constexpr uint32_t BIOS_B0 = 0xB0u;
+constexpr uint32_t BIOS_C0 = 0xC0u;
+
+struct BiosEvent {
+    uint32_t eventClass;
+    uint32_t spec;
+    uint32_t mode;
+    bool open;
+    bool enabled;
+    bool ready;
+};
+
+struct BiosFile {
+    std::string name;
+    uint32_t position;
+};
+
+// High level emulation of the BIOS functions guests call most
+// Each runs natively and returns straight to $31 while anything not
+// implemented here is left to the guest's own BIOS code at the vector
+// Files are read from images added by the host and writes to the
+// TTY descriptors are collected on the console
+class Bios {
+public:
+    Bios();
+    bool Call(R3051&, uint32_t);
+    void AddFile(const std::string&, std::vector<uint8_t>);
+    void DeliverEvent(uint32_t, uint32_t);
+    [[nodiscard]] const std::string& Console() const;
+private:
+    bool CallA0(R3051&, uint32_t);
+    bool CallB0(R3051&, uint32_t);
+    uint32_t OpenEvent(uint32_t, uint32_t, uint32_t);
+    BiosEvent* FindEvent(uint32_t);
+    uint32_t OpenFile(R3051&, uint32_t);
+    uint32_t ReadFile(R3051&, uint32_t, uint32_t, uint32_t);
+    uint32_t WriteFile(R3051&, uint32_t, uint32_t, uint32_t);
+    uint32_t CloseFile(uint32_t);
+    std::string console;
+    std::vector<BiosEvent> events;
+    std::unordered_map<std::string, std::vector<uint8_t>> images;
+    std::unordered_map<uint32_t, BiosFile> files;
+    uint32_t nextDescriptor;
+};
+
+[[nodiscard]] bool IsBiosVector(uint32_t);
+
+// Called by compiled code at a BIOS vector, the PC only
+// changes if the call was handled
+void CallBios(R3051*, uint32_t);
+
+}
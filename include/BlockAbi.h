@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "X64.h"
+
+namespace rbrown {
+
+class CodeBuffer;
+class EmitterX64;
+class R3051;
+
+// Compiled blocks are entered as block(processor, helpers)
+// Both arguments are moved into callee saved registers by the prologue
+// so that nothing specific to a processor instance is baked into the code
+constexpr uint32_t CONTEXT = RBX;
+constexpr uint32_t HELPERS = R13;
+
+// HI and LO stay in callee saved registers from a multiply or divide
+// until they are read, see RecompilerState::GetHiLoCached
+constexpr uint32_t HOST_LO = R14;
+constexpr uint32_t HOST_HI = R15;
+
+using CompiledBlock = void (*)(R3051*, const uintptr_t*);
+
+void EmitBlockPrologue(EmitterX64&);
+void EmitBlockEpilogue(EmitterX64&);
+void EmitCallHelper(EmitterX64&, uint32_t);
+void EmitLoadGuestRegister(EmitterX64&, uint32_t, uint32_t);
+void EmitStoreGuestRegister(EmitterX64&, uint32_t, uint32_t);
+void EmitStorePC(EmitterX64&, uint32_t);
+
+CompiledBlock BlockAt(const CodeBuffer&, size_t);
+
+}
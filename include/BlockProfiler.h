@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "CodeCache.h"
+
+namespace rbrown {
+
+class EmitterX64;
+class Memory;
+
+// Counters are bumped by the compiled code itself, so they must not move
+// once a block holds their address
+struct BlockProfile {
+    uint64_t count;
+    uint64_t cycles;
+    std::vector<TraceBlock> blocks;
+    uintptr_t code;
+    size_t size;
+};
+
+// Instruments every block compiled while it is attached to a code cache
+// Each block increments its own counter on entry, with timing the block is
+// entered through a stub that also accumulates the rdtsc cycles spent in it
+// Traces are always entered through a stub since they may be abandoned
+// before any code is emitted for them
+// Nothing is emitted unless a profiler is attached, so compiling without one
+// costs exactly what it did before
+// Counts are not atomic, instances sharing blocks on other threads can lose
+// increments, which is fine for finding hot code
+class BlockProfiler {
+public:
+    explicit BlockProfiler(bool);
+    BlockProfiler(const BlockProfiler&) = delete;
+    BlockProfiler& operator=(const BlockProfiler&) = delete;
+    [[nodiscard]] bool Timing() const;
+    [[nodiscard]] size_t ProfileCount() const;
+    BlockProfile* Allocate();
+    void EmitCounter(EmitterX64&, BlockProfile*) const;
+    void EmitEntry(EmitterX64&, BlockProfile*, CompiledBlock) const;
+    [[nodiscard]] std::vector<const BlockProfile*> TopByCount(size_t) const;
+    [[nodiscard]] std::vector<const BlockProfile*> TopByCycles(size_t) const;
+    [[nodiscard]] std::string Report(const Memory&, size_t) const;
+private:
+    bool timing;
+    std::deque<BlockProfile> profiles;
+};
+
+}
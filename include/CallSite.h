@@ -7,9 +7,13 @@ namespace rbrown {
 class CallSite {
 public:
     explicit CallSite(size_t);
+    // Wide call sites hold a rel32 displacement rather than a rel8
+    CallSite(size_t, bool);
     [[nodiscard]] size_t Position() const;
+    [[nodiscard]] bool Wide() const;
 private:
     size_t position;
+    bool wide;
 };
 
 }
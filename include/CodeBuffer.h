@@ -3,27 +3,46 @@
 #include <cstddef>
 #include <cstdint>
 #include <initializer_list>
+#include <unordered_map>
 
 namespace rbrown {
 
+// Room kept at the end of every buffer for call veneers
+constexpr size_t VENEER_ISLAND_SIZE = 0x1000u;
+constexpr size_t VENEER_SIZE = 16u;
+
+// Buffers are placed within rel32 reach of the executable when there is room
+// Calls to anything further away go through a veneer, a jmp [rip] shared by
+// every call to the same target, kept in an island at the end of the buffer
+// With huge pages the length is rounded up to a whole number of them
 class CodeBuffer {
 public:
-    explicit CodeBuffer(size_t);
+    explicit CodeBuffer(size_t, bool = false);
     ~CodeBuffer();
     void Protect();
+    void ProtectWriteExecute();
     void Call();
     [[nodiscard]] uintptr_t BufferAddress() const;
     [[nodiscard]] size_t Position() const;
+    [[nodiscard]] size_t Length() const;
+    [[nodiscard]] uint32_t PageMode() const;
+    [[nodiscard]] uintptr_t Veneer(uintptr_t);
+    [[nodiscard]] size_t VeneerCount() const;
     void Byte(uint8_t);
     void Byte(size_t, uint8_t);
     void Bytes(const std::initializer_list<uint8_t>&);
     void Word(uint16_t);
     void DWord(uint32_t);
+    void DWord(size_t, uint32_t);
     void QWord(uint64_t);
 private:
     void* buffer;
+    size_t mapped;
     size_t length;
     size_t pos;
+    uint32_t pageMode;
+    size_t veneerTop;
+    std::unordered_map<uintptr_t, size_t> veneers;
 };
 
 }
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "BlockAbi.h"
+#include "CodeBuffer.h"
+#include "HelperTable.h"
+
+namespace rbrown {
+
+class BlockProfiler;
+class EmitterX64;
+class GdbJit;
+class JitStats;
+class Memory;
+class PerfMap;
+
+// Room that must remain in the buffer before a block is compiled, and for each
+// block on the path of a trace, so compilers must never emit more than this for one
+constexpr size_t MAX_BLOCK_SIZE = 0x2000u;
+
+// Emits a block for the guest code at the given PC and returns
+// the number of guest instructions the block covers
+using BlockCompiler = uint32_t (*)(EmitterX64&, const Memory&, uint32_t);
+
+struct TraceBlock {
+    uint32_t pc;
+    uint32_t length;
+};
+
+// Emits a superblock for a path of block PCs and returns the blocks it covers
+using TraceCompiler = std::vector<TraceBlock> (*)(EmitterX64&, const Memory&, const std::vector<uint32_t>&);
+
+struct CachedBlock {
+    uint32_t pc;
+    uint32_t length;
+    uint64_t hash;
+    CompiledBlock code;
+};
+
+// Traces are built from the profile of a single instance and belong to it alone
+struct CachedTrace {
+    std::vector<TraceBlock> blocks;
+    CompiledBlock code;
+};
+
+// A code cache shared between any number of processors and threads
+// Blocks are keyed on both their PC and a hash of the guest code they were
+// compiled from so instances running different code at the same address
+// each get the right translation
+// The buffer can be backed by huge pages so a large cache doesn't thrash the iTLB
+class CodeCache {
+public:
+    CodeCache(size_t, BlockCompiler, TraceCompiler = nullptr, bool = false);
+    [[nodiscard]] const HelperTable& Helpers() const;
+    [[nodiscard]] size_t BlockCount() const;
+    [[nodiscard]] uint32_t PageMode() const;
+    [[nodiscard]] CachedBlock Lookup(const Memory&, uint32_t);
+    [[nodiscard]] CachedTrace CompileTrace(const Memory&, const std::vector<uint32_t>&);
+    void FlushDebugInfo();
+    void AttachPerfMap(PerfMap*);
+    void AttachGdbJit(GdbJit*);
+    void AttachProfiler(BlockProfiler*);
+    void AttachStats(JitStats*);
+private:
+    [[nodiscard]] const CachedBlock* Find(const Memory&, uint32_t) const;
+    CodeBuffer buffer;
+    HelperTable helpers;
+    BlockCompiler compiler;
+    TraceCompiler traceCompiler;
+    PerfMap* perfMap;
+    GdbJit* gdbJit;
+    BlockProfiler* profiler;
+    JitStats* stats;
+    mutable std::shared_mutex mutex;
+    std::unordered_multimap<uint32_t, CachedBlock> blocks;
+};
+
+uint64_t HashGuestCode(const Memory&, uint32_t, uint32_t);
+
+}
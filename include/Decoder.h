@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace rbrown {
+
+class EmitterX64;
+class R3051;
+class RecompilerState;
+
+using InterpreterFunction = void (*)(R3051*, uint32_t);
+using EmitterFunction = void (*)(RecompilerState&, EmitterX64&, uint32_t);
+
+constexpr uint32_t READS_RS = 1u << 0u;
+constexpr uint32_t READS_RT = 1u << 1u;
+constexpr uint32_t WRITES_RD = 1u << 2u;
+constexpr uint32_t WRITES_RT = 1u << 3u;
+constexpr uint32_t WRITES_RA = 1u << 4u;
+constexpr uint32_t CAN_FAULT = 1u << 5u;
+constexpr uint32_t IS_BRANCH = 1u << 6u;
+constexpr uint32_t IS_LOAD = 1u << 7u;
+constexpr uint32_t IS_STORE = 1u << 8u;
+
+// Everything the interpreter and the recompiler need to know about an instruction
+// Instructions without a native implementation have a null emitter
+struct InstructionInfo {
+    const char* mnemonic;
+    InterpreterFunction interpret;
+    EmitterFunction emit;
+    uint32_t flags;
+};
+
+constexpr uint32_t DECODE_TABLE_SIZE = 224u;
+
+uint32_t DecodeIndex(uint32_t);
+const InstructionInfo& DecodeInstruction(uint32_t);
+const InstructionInfo& InstructionAt(uint32_t);
+
+// Formats the instruction at the given PC the way an assembler listing would
+std::string DisassembleInstruction(uint32_t, uint32_t);
+
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <cstdint>
 #include <memory>
 #include <map>
@@ -10,42 +12,104 @@ namespace rbrown {
 
 class CodeBuffer;
 
+// 64 bit constants and far call targets can be loaded RIP relative from a literal pool
+// Anything that used one must be followed by EmitLiteralPool, somewhere execution
+// never falls through to, before the code runs
 class EmitterX64 {
 public:
     explicit EmitterX64(CodeBuffer&);
+    [[nodiscard]] uint64_t LabelCount() const;
+    [[nodiscard]] uint64_t FixUpCount() const;
+    [[nodiscard]] uint64_t CallCount() const;
+    [[nodiscard]] const std::vector<size_t>& Returns() const;
     Label NewLabel();
     void Bind(Label&);
     void Jno(const Label&);
+    void Je(const Label&);
     void Jne(const Label&);
     void Js(const Label&);
+    void Jl(const Label&);
+    void Jge(const Label&);
+    void Jle(const Label&);
+    void Jg(const Label&);
     void Jmp(const Label&);
+    void Jmp32(const Label&);
     void TestALImm8(uint8_t);
     void CmpR32Imm8(uint32_t, uint8_t);
+    void CmpR32R32(uint32_t, uint32_t);
+    void CmpR32Imm32(uint32_t, uint32_t);
+    void CmpDisp32Imm8(uint32_t, uint32_t, uint8_t);
     void AddR32R32(uint32_t, uint32_t);
     void AddR32Imm32(uint32_t, uint32_t);
     void AddR64Imm8(uint32_t, uint8_t);
+    void AddDisp8R64(uint32_t, uint8_t, uint32_t);
+    void IncQwordDisp8(uint32_t, uint8_t);
     void SubR32R32(uint32_t, uint32_t);
+    void SubR64R64(uint32_t, uint32_t);
     void SubR64Imm8(uint32_t, uint8_t);
+    void SubDisp32Imm32(uint32_t, uint32_t, uint32_t);
+    void AndR32R32(uint32_t, uint32_t);
+    void AndR32Imm32(uint32_t, uint32_t);
+    void OrR32R32(uint32_t, uint32_t);
+    void OrR64R64(uint32_t, uint32_t);
+    void OrR32Imm32(uint32_t, uint32_t);
+    void XorR32R32(uint32_t, uint32_t);
+    void XorR32Imm32(uint32_t, uint32_t);
+    void NotR32(uint32_t);
+    void MulR32(uint32_t);
+    void ImulR32(uint32_t);
+    void DivR32(uint32_t);
+    void IdivR32(uint32_t);
+    void Cdq();
+    void Rdtsc();
+    void ShlR32Imm8(uint32_t, uint8_t);
+    void ShlR64Imm8(uint32_t, uint8_t);
+    void ShrR32Imm8(uint32_t, uint8_t);
+    void SarR32Imm8(uint32_t, uint8_t);
+    void ShlR32CL(uint32_t);
+    void ShrR32CL(uint32_t);
+    void SarR32CL(uint32_t);
+    void SetlR8(uint32_t);
+    void SetbR8(uint32_t);
+    void MovzxR32R8(uint32_t, uint32_t);
     void MovR32R32(uint32_t, uint32_t);
     void MovR32Disp8(uint32_t, uint32_t, uint8_t);
     void MovDisp8R32(uint32_t, uint8_t, uint32_t);
+    void MovR32Disp32(uint32_t, uint32_t, uint32_t);
+    void MovDisp32R32(uint32_t, uint32_t, uint32_t);
+    void MovDisp32Imm32(uint32_t, uint32_t, uint32_t);
     void MovR32Imm32(uint32_t, uint32_t);
     void MovR64R64(uint32_t, uint32_t);
     void MovR64Imm64(uint32_t, uint64_t);
+    void MovR64Literal(uint32_t, uint64_t);
     void MovEAXAbs(uintptr_t);
     void MovAbsEAX(uintptr_t);
     void LeaR64Disp8(uint32_t, uint32_t, uint8_t);
+    void LeaR64Disp32(uint32_t, uint32_t, uint32_t);
     void PushR64(uint32_t);
     void PopR64(uint32_t);
+    void JmpRel32(uint32_t);
+    void Jmp(uintptr_t);
+    void JmpLiteral(uintptr_t);
     void CallRel32(uint32_t);
     void Call(uintptr_t);
+    void CallLiteral(uintptr_t);
+    void CallDisp8(uint32_t, uint8_t);
+    void CallDisp32(uint32_t, uint32_t);
     void Ret();
+    void EmitLiteralPool();
 private:
     void FixUpCallSite(const CallSite&, const Label&);
 private:
     CodeBuffer& buffer;
     std::map<uint64_t, std::vector<CallSite>> callSites;
+    // Ends of the RIP relative instructions waiting on each pooled value
+    std::map<uint64_t, std::vector<size_t>> literalSites;
     uint64_t nextLabelId;
+    uint64_t fixUpCount;
+    uint64_t callCount;
+    // Buffer positions of every RET, where the frames built in the code end
+    std::vector<size_t> returns;
 };
 
 template<typename T>
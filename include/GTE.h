@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rbrown {
+
+// The geometry transformation engine, coprocessor 2
+// Data registers are accessed with MFC2, MTC2, LWC2 and SWC2
+// and control registers with CFC2 and CTC2
+// Commands take the whole opcode for their sf, lm and MVMVA fields
+class GTE {
+public:
+    GTE();
+    [[nodiscard]] uint32_t ReadRegister(uint32_t) const;
+    void WriteRegister(uint32_t, uint32_t);
+    [[nodiscard]] uint32_t ReadControl(uint32_t) const;
+    void WriteControl(uint32_t, uint32_t);
+
+    void Rtps(uint32_t);
+    void Rtpt(uint32_t);
+    void Nclip(uint32_t);
+    void Op(uint32_t);
+    void Dpcs(uint32_t);
+    void Dpct(uint32_t);
+    void Intpl(uint32_t);
+    void Mvmva(uint32_t);
+    void Ncds(uint32_t);
+    void Ncdt(uint32_t);
+    void Cdp(uint32_t);
+    void Nccs(uint32_t);
+    void Ncct(uint32_t);
+    void Cc(uint32_t);
+    void Ncs(uint32_t);
+    void Nct(uint32_t);
+    void Sqr(uint32_t);
+    void Dcpl(uint32_t);
+    void Avsz3(uint32_t);
+    void Avsz4(uint32_t);
+    void Gpf(uint32_t);
+    void Gpl(uint32_t);
+    void Reserved(uint32_t);
+private:
+    void Begin();
+    void End();
+    void Transform(int64_t*, const int32_t*, const int32_t*, const int64_t*);
+    void SetMacIr(uint32_t, int64_t, uint32_t, bool);
+    void SetMac(uint32_t, int64_t, uint32_t);
+    void SetIr(uint32_t, int32_t, bool);
+    void SetMac0(int64_t);
+    void SetIr0(int32_t);
+    void PushScreenXY(int64_t, int64_t);
+    void PushScreenZ(int32_t);
+    void PushColor();
+    void RotateTranslatePerspective(uint32_t, uint32_t, bool, bool);
+    void Light(const int32_t*, uint32_t, bool);
+    void ColorMatrix(uint32_t, bool);
+    void InterpolateColor(int64_t, int64_t, int64_t, uint32_t, bool);
+    void NormalColorDepth(uint32_t, uint32_t, bool);
+    void NormalColorColor(uint32_t, uint32_t, bool);
+    void NormalColor(uint32_t, uint32_t, bool);
+    void DepthCue(uint32_t, uint32_t, bool);
+    [[nodiscard]] int32_t Vector(uint32_t, uint32_t) const;
+    [[nodiscard]] int32_t Ir(uint32_t) const;
+    void Matrix(uint32_t, int32_t*) const;
+    void Translation(uint32_t, int64_t*) const;
+    [[nodiscard]] int64_t Color(uint32_t) const;
+    uint32_t data[32];
+    uint32_t control[32];
+};
+
+constexpr uint32_t GTE_COMMAND_COUNT = 64u;
+
+using GteCommand = void (*)(GTE*, uint32_t);
+
+// Indexed by the function field of a COP2 command
+GteCommand GteCommandAt(uint32_t);
+
+const char* GteInstructionSet();
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rbrown {
+
+// How the code under a symbol builds its frame, a block runs EmitBlockPrologue
+// at some offset and the entries a profiler puts in front of a block either
+// jump to it without a frame or save RBX and R12 to time a call to it
+constexpr uint32_t FRAME_BLOCK = 0u;
+constexpr uint32_t FRAME_JUMP = 1u;
+constexpr uint32_t FRAME_TIMING = 2u;
+
+struct GdbJitSymbol {
+    std::string name;
+    uintptr_t code;
+    size_t size;
+    uint32_t frame;
+    size_t prologue;
+    // Offsets of the RET ending each way out of the frame
+    std::vector<uint32_t> returns;
+};
+
+struct GdbJitObject;
+
+// Registers compiled code with a debugger through the GDB JIT interface
+// Each registration is an in-memory ELF object with a symbol for every block
+// and call frame information for the frame built by EmitBlockPrologue,
+// enough for a debugger or unwinder to name blocks and walk through them
+// A profiler's counter shifts the prologue into the block and its entry
+// stubs get symbols and frames of their own
+// Blocks are batched so that compiling costs next to nothing when no
+// debugger is attached, Flush registers whatever is still waiting and the
+// code cache calls it at the end of every run slice
+class GdbJit {
+public:
+    GdbJit();
+    ~GdbJit();
+    GdbJit(const GdbJit&) = delete;
+    GdbJit& operator=(const GdbJit&) = delete;
+    void RecordBlock(uint32_t, uintptr_t, size_t, size_t, const std::vector<uintptr_t>&);
+    void RecordTrace(uint32_t, uintptr_t, size_t, const std::vector<uintptr_t>&);
+    void RecordEntry(uint32_t, uintptr_t, size_t, bool, const std::vector<uintptr_t>&);
+    void Flush();
+    [[nodiscard]] size_t RegisteredCount() const;
+private:
+    void Record(std::string, uintptr_t, size_t, uint32_t, size_t, const std::vector<uintptr_t>&);
+    std::vector<GdbJitSymbol> pending;
+    std::vector<std::unique_ptr<GdbJitObject>> registered;
+};
+
+}
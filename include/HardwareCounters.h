@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rbrown {
+
+constexpr uint32_t HW_INSTRUCTIONS = 0u;
+constexpr uint32_t HW_CYCLES = 1u;
+constexpr uint32_t HW_ITLB_MISSES = 2u;
+constexpr uint32_t HW_BRANCH_MISSES = 3u;
+constexpr uint32_t HW_L1I_MISSES = 4u;
+constexpr uint32_t HW_COUNTER_COUNT = 5u;
+
+// The guest code a run slice went through, from the lowest block PC
+// to the end of the highest block
+struct GuestRange {
+    uint32_t start;
+    uint32_t end;
+};
+
+// A counter's raw value with the times it has been enabled and actually counting
+struct HardwareReading {
+    uint64_t count;
+    uint64_t enabled;
+    uint64_t running;
+};
+
+struct HardwareSample {
+    std::array<uint64_t, HW_COUNTER_COUNT> values;
+};
+
+struct HardwareRange {
+    GuestRange range;
+    uint64_t slices;
+    HardwareSample sample;
+};
+
+// Host performance counters read around each run slice of an instance
+// Counters are opened with perf_event_open for the calling thread and user
+// space only, so the object belongs to the thread that runs the instance
+// Counters the host or its perf_event_paranoid setting won't give us are left
+// out and read as zero, and values are scaled up when the kernel multiplexes
+// Each slice is charged to the range of guest code it ran so that changes to
+// the code cache layout can be judged on measured iTLB and i-cache misses
+class HardwareCounters {
+public:
+    HardwareCounters();
+    ~HardwareCounters();
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+    [[nodiscard]] bool Available(uint32_t) const;
+    void Begin();
+    void End(const GuestRange&);
+    [[nodiscard]] HardwareSample Total() const;
+    [[nodiscard]] std::vector<HardwareRange> TopRanges(uint32_t, size_t) const;
+    [[nodiscard]] std::string Report(size_t) const;
+private:
+    std::array<int, HW_COUNTER_COUNT> files;
+    std::array<HardwareReading, HW_COUNTER_COUNT> starts;
+    std::map<uint64_t, HardwareRange> ranges;
+    HardwareSample total;
+};
+
+}
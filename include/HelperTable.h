@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Decoder.h"
+#include "GTE.h"
+
+namespace rbrown {
+
+constexpr uint32_t HELPER_WRITE_PC = 0u;
+constexpr uint32_t HELPER_ENTER_EXCEPTION = 1u;
+constexpr uint32_t HELPER_LOAD_WORD = 2u;
+constexpr uint32_t HELPER_STORE_WORD = 3u;
+constexpr uint32_t HELPER_SET_LOAD_DELAY_VALUE = 4u;
+constexpr uint32_t HELPER_SET_LOAD_DELAY_REGISTER = 5u;
+constexpr uint32_t HELPER_SET_LOAD_DELAY_SLOT = 6u;
+constexpr uint32_t HELPER_SET_LOAD_DELAY_SLOT_NEXT = 7u;
+constexpr uint32_t HELPER_SET_BRANCH_DELAY_SLOT = 8u;
+constexpr uint32_t HELPER_RETIRE_LOAD = 9u;
+constexpr uint32_t HELPER_RETIRE_BRANCH = 10u;
+// Followed by the interpreter function of every decode table entry
+constexpr uint32_t HELPER_INTERPRET = 11u;
+// Followed by every GTE command indexed by function
+constexpr uint32_t HELPER_GTE_COMMAND = HELPER_INTERPRET + DECODE_TABLE_SIZE;
+constexpr uint32_t HELPER_CALL_BIOS = HELPER_GTE_COMMAND + GTE_COMMAND_COUNT;
+constexpr uint32_t HELPER_COUNT = HELPER_CALL_BIOS + 1u;
+
+// Compiled code never embeds the address of a helper function
+// Instead it calls indirectly through a table owned by the code cache
+// whose address is passed in when a block is entered
+class HelperTable {
+public:
+    HelperTable();
+    [[nodiscard]] uintptr_t Address(uint32_t) const;
+    [[nodiscard]] const uintptr_t* Entries() const;
+    [[nodiscard]] static uint32_t Offset(uint32_t);
+    void Register(uint32_t, uintptr_t);
+private:
+    uintptr_t entries[HELPER_COUNT];
+};
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Bios.h"
+#include "CodeCache.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "PredecodedInterpreter.h"
+#include "Scheduler.h"
+
+namespace rbrown {
+
+class HardwareCounters;
+struct GuestRange;
+
+// How often a block was left for each of its first two successors
+// Conditional branches have no more than two and anything else is ignored
+struct EdgeCounts {
+    uint32_t targets[2];
+    uint32_t counts[2];
+};
+
+// How a block leaves, so the dispatcher can guess where it goes next
+constexpr uint32_t EXIT_CALL = 1u << 0u;
+constexpr uint32_t EXIT_RETURN = 1u << 1u;
+
+constexpr size_t RETURN_STACK_SIZE = 16u;
+
+struct DispatchEntry {
+    CachedBlock block;
+    // The block itself or a trace that starts with it
+    CompiledBlock code;
+    uint32_t exit;
+    // Where a call returns to and the entry found there the first time it did
+    uint32_t returnAddress;
+    DispatchEntry* returnEntry;
+    // Where any other exit went last time
+    uint32_t lastTarget;
+    DispatchEntry* lastEntry;
+    EdgeCounts edges;
+};
+
+// Pushed for each call and popped by JR $ra
+struct ReturnPrediction {
+    uint32_t address;
+    DispatchEntry* caller;
+};
+
+// A single guest machine running out of a shared code cache
+// The instance keeps its own dispatch table so that invalidating
+// its code never disturbs any other instance
+// Its predecoded interpreter is invalidated along with the dispatch table
+// Scheduled events run between blocks once the processor's downcount runs out
+// The edges taken between blocks are counted and once one is hot the path
+// following it is compiled into a trace that is run in place of its first block
+// Calls into the BIOS tables run natively where the HLE layer implements them
+// Returns are predicted with a return stack and every other exit with the
+// successor it went to last time so that a hit skips the dispatch table
+// With hardware counters attached each call to Run is measured as one slice
+// Guest RAM can be backed by huge pages like the code cache
+class Instance {
+public:
+    Instance(CodeCache&, size_t, bool = false);
+    R3051& Processor();
+    Memory& Ram();
+    Scheduler& Events();
+    Bios& Hle();
+    bool Run(uint32_t);
+    void AttachCounters(HardwareCounters*);
+    uint32_t Interpret(uint32_t);
+    void Invalidate(uint32_t, uint32_t);
+    [[nodiscard]] size_t TraceCount() const;
+private:
+    bool Dispatch(uint32_t, GuestRange*);
+    DispatchEntry* Lookup(uint32_t);
+    DispatchEntry* Follow(DispatchEntry&, uint32_t);
+    void CountEdge(DispatchEntry&, uint32_t);
+    void FormTrace(uint32_t);
+    CodeCache& cache;
+    Memory memory;
+    R3051 processor;
+    Scheduler scheduler;
+    Bios bios;
+    PredecodedInterpreter interpreter;
+    std::unordered_map<uint32_t, DispatchEntry> dispatch;
+    std::unordered_map<uint32_t, CachedTrace> traces;
+    std::array<ReturnPrediction, RETURN_STACK_SIZE> returns;
+    size_t returnTop;
+    DispatchEntry* previous;
+    HardwareCounters* counters;
+};
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rbrown {
+
+class R3051;
+
+void Step(R3051*);
+uint32_t Run(R3051*, uint32_t);
+
+}
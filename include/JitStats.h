@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace rbrown {
+
+// What one compile of a block or trace produced and what it cost
+struct JitCompile {
+    uint64_t guestInstructions;
+    uint64_t hostBytes;
+    uint64_t helperCalls;
+    uint64_t fallbacks;
+    uint64_t labels;
+    uint64_t fixUps;
+    uint64_t nanoseconds;
+};
+
+constexpr uint32_t JIT_STAT_GUEST_INSTRUCTIONS = 0u;
+constexpr uint32_t JIT_STAT_HOST_BYTES = 1u;
+constexpr uint32_t JIT_STAT_BYTES_PER_INSTRUCTION = 2u;
+constexpr uint32_t JIT_STAT_HELPER_CALLS = 3u;
+constexpr uint32_t JIT_STAT_FALLBACKS = 4u;
+constexpr uint32_t JIT_STAT_LABELS = 5u;
+constexpr uint32_t JIT_STAT_FIXUPS = 6u;
+constexpr uint32_t JIT_STAT_NANOSECONDS = 7u;
+constexpr uint32_t JIT_STAT_COUNT = 8u;
+
+// Bucket 0 holds zero and bucket i values from 2^(i-1) up to 2^i
+constexpr uint32_t JIT_HISTOGRAM_BUCKETS = 48u;
+
+struct JitHistogram {
+    uint64_t samples;
+    uint64_t total;
+    uint64_t minimum;
+    uint64_t maximum;
+    std::array<uint64_t, JIT_HISTOGRAM_BUCKETS> buckets;
+};
+
+// Aggregates the metrics of every compile done while attached to a code cache
+// so that changes to the emitters show up as code growth or compile time
+// With a dump interval the report is rewritten to /tmp/jit-stats-<pid>.txt
+// every that many compiles, otherwise it is only produced on request
+class JitStats {
+public:
+    explicit JitStats(uint64_t);
+    JitStats(const JitStats&) = delete;
+    JitStats& operator=(const JitStats&) = delete;
+    void Record(const JitCompile&);
+    [[nodiscard]] uint64_t CompileCount() const;
+    [[nodiscard]] JitHistogram Histogram(uint32_t) const;
+    [[nodiscard]] std::string Report() const;
+private:
+    [[nodiscard]] std::string ReportLocked() const;
+    void Dump() const;
+    uint64_t dumpInterval;
+    uint64_t compiles;
+    std::array<JitHistogram, JIT_STAT_COUNT> histograms;
+    mutable std::mutex mutex;
+};
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rbrown {
+
+class R3051;
+
+constexpr uint32_t LOCKSTEP_LANES = 16u;
+
+// Register files for a batch of processors stored as structure of arrays
+// so that one instruction can be executed for every lane at once
+// A lane that can no longer follow the batch (an exception for instance)
+// is written back to its processor and continues on the scalar interpreter
+class LockstepBatch {
+public:
+    LockstepBatch();
+    void Gather(R3051* const*, uint32_t);
+    void Scatter() const;
+    void Diverge(uint32_t);
+    [[nodiscard]] uint32_t ActiveLanes() const;
+    [[nodiscard]] R3051* Lane(uint32_t) const;
+    [[nodiscard]] uint32_t* Registers(uint32_t);
+private:
+    void ScatterLane(uint32_t) const;
+    alignas(64) uint32_t registers[32][LOCKSTEP_LANES];
+    R3051* lanes[LOCKSTEP_LANES];
+    uint32_t active;
+};
+
+void LockstepAddu(LockstepBatch*, uint32_t);
+void LockstepSubu(LockstepBatch*, uint32_t);
+void LockstepAddiu(LockstepBatch*, uint32_t);
+uint32_t LockstepAdd(LockstepBatch*, uint32_t);
+
+const char* LockstepInstructionSet();
+
+}
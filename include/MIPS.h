@@ -1,11 +1,25 @@
 #pragma once
 
+#include <cstddef>
+#include <atomic>
 #include <cstdint>
 
+#include "GTE.h"
+
 namespace rbrown {
 
+constexpr uint32_t INTERRUPT = 0u;
+constexpr uint32_t ADDRESS_ERROR_LOAD = 4u;
+constexpr uint32_t ADDRESS_ERROR_STORE = 5u;
+constexpr uint32_t SYSCALL = 8u;
+constexpr uint32_t BREAKPOINT = 9u;
+constexpr uint32_t RESERVED_INSTRUCTION = 10u;
+constexpr uint32_t COPROCESSOR_UNUSABLE = 11u;
 constexpr uint32_t ARITHMETIC_OVERFLOW = 12u;
 
+class Bios;
+class Memory;
+
 class COP0 {
 public:
     COP0();
@@ -14,6 +28,9 @@ public:
     void WriteRegisterMasked(uint32_t, uint32_t, uint32_t);
 
     uint32_t EnterException(uint32_t, uint32_t, uint32_t);
+    void ReturnFromException();
+    void SetInterruptLines(uint32_t);
+    [[nodiscard]] bool InterruptPending() const;
 private:
     uint32_t registers[32];
 };
@@ -22,31 +39,78 @@ class R3051 {
 public:
     R3051();
 
+    [[nodiscard]] static size_t RegisterOffset(uint32_t);
+    [[nodiscard]] static size_t PCOffset();
+    [[nodiscard]] static size_t HiOffset();
+    [[nodiscard]] static size_t LoOffset();
+    [[nodiscard]] static size_t Cop2Offset();
+    [[nodiscard]] static size_t DowncountOffset();
+    [[nodiscard]] static size_t ExitRequestOffset();
+
     [[nodiscard]] uintptr_t RegisterAddress(uint32_t) const;
     [[nodiscard]] uint32_t ReadRegister(uint32_t) const;
     [[nodiscard]] uint32_t ReadPC() const;
+    [[nodiscard]] uint32_t ReadHi() const;
+    [[nodiscard]] uint32_t ReadLo() const;
+    [[nodiscard]] int32_t GetDowncount() const;
+    [[nodiscard]] bool ExitRequested() const;
+    [[nodiscard]] uint32_t GetInterruptLines() const;
     [[nodiscard]] bool GetLoadDelaySlot() const;
     [[nodiscard]] bool GetLoadDelaySlotNext() const;
     [[nodiscard]] uint32_t GetLoadDelayRegister() const;
     [[nodiscard]] uint32_t GetLoadDelayValue() const;
+    [[nodiscard]] uint32_t GetBranchTarget() const;
+    [[nodiscard]] bool GetBranchDelaySlot() const;
+    [[nodiscard]] bool GetBranchDelaySlotNext() const;
 
     void WriteRegister(uint32_t, uint32_t);
     void WritePC(uint32_t);
+    void WriteHi(uint32_t);
+    void WriteLo(uint32_t);
+    void SetDowncount(int32_t);
+    void RequestExit();
+    void ClearExitRequest();
+    void AssertInterrupt(uint32_t);
+    void DeassertInterrupt(uint32_t);
     void SetLoadDelaySlot(bool);
     void SetLoadDelaySlotNext(bool);
     void SetLoadDelayRegister(uint32_t);
     void SetLoadDelayValue(uint32_t);
+    void SetBranchTarget(uint32_t);
+    void SetBranchDelaySlot(bool);
+    void SetBranchDelaySlotNext(bool);
 
     COP0& Cop0();
+    GTE& Cop2();
+
+    [[nodiscard]] Memory* GetMemory() const;
+    void AttachMemory(Memory*);
+    [[nodiscard]] Bios* GetBios() const;
+    void AttachBios(Bios*);
 
 private:
     uint32_t registers[32];
     uint32_t pc;
+    uint32_t hi;
+    uint32_t lo;
+    // Cycles left until the next scheduled event, compiled blocks
+    // subtract their cost on entry
+    int32_t downcount;
+    // Set from any thread to make the processor stop at the next safe point
+    // Every reason to stop shares it so running code only has one word to test
+    std::atomic<uint32_t> exitRequest;
+    std::atomic<uint32_t> interruptLines;
     COP0 cop0;
+    GTE cop2;
     bool loadDelaySlot;
     bool loadDelaySlotNext;
     uint32_t loadDelayRegister;
     uint32_t loadDelayValue;
+    uint32_t branchTarget;
+    bool branchDelaySlot;
+    bool branchDelaySlotNext;
+    Memory* memory;
+    Bios* bios;
 };
 
 uint32_t ReadPC(R3051*);
@@ -55,8 +119,14 @@ void SetLoadDelaySlot(R3051*, bool);
 void SetLoadDelaySlotNext(R3051*, bool);
 void SetLoadDelayRegister(R3051*, uint32_t);
 void SetLoadDelayValue(R3051*, uint32_t);
+void SetBranchTarget(R3051*, uint32_t);
+void SetBranchDelaySlot(R3051*, bool);
+void SetBranchDelaySlotNext(R3051*, bool);
 
 void EnterException(R3051*, uint32_t);
+bool ServiceExitRequest(R3051*);
+void RetireLoad(R3051*);
+void RetireBranch(R3051*, uint32_t);
 
 uint32_t InstructionFunction(uint32_t);
 uint32_t InstructionRd(uint32_t);
@@ -65,6 +135,8 @@ uint32_t InstructionRs(uint32_t);
 uint32_t InstructionOp(uint32_t);
 uint32_t InstructionImmediate(uint32_t);
 uint32_t InstructionImmediateExtended(uint32_t);
+uint32_t InstructionShift(uint32_t);
+uint32_t InstructionTarget(uint32_t);
 
 void WriteRegisterRd(R3051*, uint32_t, uint32_t);
 void WriteRegisterRt(R3051*, uint32_t, uint32_t);
@@ -72,7 +144,11 @@ uint32_t ReadRegisterRt(R3051*, uint32_t);
 uint32_t ReadRegisterRs(R3051*, uint32_t);
 
 bool StoreWord(R3051*, uint32_t, uint32_t);
+bool StoreHalf(R3051*, uint32_t, uint32_t);
+bool StoreByte(R3051*, uint32_t, uint32_t);
 bool LoadWord(R3051*, uint32_t, uint32_t*);
+bool LoadHalf(R3051*, uint32_t, uint32_t*);
+bool LoadByte(R3051*, uint32_t, uint32_t*);
 
 void InterpretAddu(R3051*, uint32_t);
 void InterpretSubu(R3051*, uint32_t);
@@ -81,4 +157,74 @@ void InterpretAdd(R3051*, uint32_t);
 void InterpretSw(R3051*, uint32_t);
 void InterpretLw(R3051*, uint32_t);
 
+void InterpretSll(R3051*, uint32_t);
+void InterpretSrl(R3051*, uint32_t);
+void InterpretSra(R3051*, uint32_t);
+void InterpretSllv(R3051*, uint32_t);
+void InterpretSrlv(R3051*, uint32_t);
+void InterpretSrav(R3051*, uint32_t);
+void InterpretJr(R3051*, uint32_t);
+void InterpretJalr(R3051*, uint32_t);
+void InterpretSyscall(R3051*, uint32_t);
+void InterpretBreak(R3051*, uint32_t);
+void InterpretSub(R3051*, uint32_t);
+void InterpretAnd(R3051*, uint32_t);
+void InterpretOr(R3051*, uint32_t);
+void InterpretXor(R3051*, uint32_t);
+void InterpretNor(R3051*, uint32_t);
+void InterpretSlt(R3051*, uint32_t);
+void InterpretSltu(R3051*, uint32_t);
+void InterpretMfhi(R3051*, uint32_t);
+void InterpretMthi(R3051*, uint32_t);
+void InterpretMflo(R3051*, uint32_t);
+void InterpretMtlo(R3051*, uint32_t);
+void InterpretMult(R3051*, uint32_t);
+void InterpretMultu(R3051*, uint32_t);
+void InterpretDiv(R3051*, uint32_t);
+void InterpretDivu(R3051*, uint32_t);
+
+void InterpretBltz(R3051*, uint32_t);
+void InterpretBgez(R3051*, uint32_t);
+void InterpretBltzal(R3051*, uint32_t);
+void InterpretBgezal(R3051*, uint32_t);
+
+void InterpretJ(R3051*, uint32_t);
+void InterpretJal(R3051*, uint32_t);
+void InterpretBeq(R3051*, uint32_t);
+void InterpretBne(R3051*, uint32_t);
+void InterpretBlez(R3051*, uint32_t);
+void InterpretBgtz(R3051*, uint32_t);
+void InterpretAddi(R3051*, uint32_t);
+void InterpretSlti(R3051*, uint32_t);
+void InterpretSltiu(R3051*, uint32_t);
+void InterpretAndi(R3051*, uint32_t);
+void InterpretOri(R3051*, uint32_t);
+void InterpretXori(R3051*, uint32_t);
+void InterpretLui(R3051*, uint32_t);
+
+void InterpretMfc0(R3051*, uint32_t);
+void InterpretMtc0(R3051*, uint32_t);
+void InterpretCop0Command(R3051*, uint32_t);
+void InterpretMfc2(R3051*, uint32_t);
+void InterpretCfc2(R3051*, uint32_t);
+void InterpretMtc2(R3051*, uint32_t);
+void InterpretCtc2(R3051*, uint32_t);
+void InterpretCop2Command(R3051*, uint32_t);
+
+void InterpretLb(R3051*, uint32_t);
+void InterpretLh(R3051*, uint32_t);
+void InterpretLwl(R3051*, uint32_t);
+void InterpretLbu(R3051*, uint32_t);
+void InterpretLhu(R3051*, uint32_t);
+void InterpretLwr(R3051*, uint32_t);
+void InterpretSb(R3051*, uint32_t);
+void InterpretSh(R3051*, uint32_t);
+void InterpretSwl(R3051*, uint32_t);
+void InterpretSwr(R3051*, uint32_t);
+void InterpretLwc2(R3051*, uint32_t);
+void InterpretSwc2(R3051*, uint32_t);
+
+void InterpretReserved(R3051*, uint32_t);
+void InterpretCoprocessorUnusable(R3051*, uint32_t);
+
 }
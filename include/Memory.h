@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rbrown {
+
+// Guest RAM, mirrored across KUSEG, KSEG0 and KSEG1
+// Optionally backed by huge pages, in which case the mapping is rounded up to them
+class Memory {
+public:
+    explicit Memory(size_t, bool = false);
+    ~Memory();
+    Memory(const Memory&) = delete;
+    Memory& operator=(const Memory&) = delete;
+    [[nodiscard]] size_t Size() const;
+    [[nodiscard]] uint32_t PageMode() const;
+    [[nodiscard]] uint32_t ReadWord(uint32_t) const;
+    [[nodiscard]] uint32_t ReadHalf(uint32_t) const;
+    [[nodiscard]] uint32_t ReadByte(uint32_t) const;
+    void WriteWord(uint32_t, uint32_t);
+    void WriteHalf(uint32_t, uint32_t);
+    void WriteByte(uint32_t, uint32_t);
+private:
+    [[nodiscard]] size_t Physical(uint32_t) const;
+    uint8_t* ram;
+    size_t size;
+    size_t mapped;
+    uint32_t pageMode;
+};
+
+}
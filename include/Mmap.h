@@ -1,13 +1,42 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 namespace rbrown::xmmap {
 
+constexpr size_t HUGE_PAGE_SIZE = 0x200000u;
+
+// How a mapping ended up backed
+constexpr uint32_t PAGES_SMALL = 0u;
+constexpr uint32_t PAGES_HUGETLB = 1u;
+constexpr uint32_t PAGES_TRANSPARENT = 2u;
+
 void* Map(size_t);
 
+// An address inside the executable, where the helpers that compiled code calls live
+uintptr_t ExecutableAddress();
+
+// Tries to place the mapping within rel32 reach of the anchor and maps it
+// anywhere when nothing nearby is free
+void* MapNear(size_t, uintptr_t);
+
+// Tries reserved 2 MiB pages, then transparent huge pages on an aligned mapping
+// and settles for small pages, setting the mode to whichever it got
+// Given an anchor the mapping is placed near it like MapNear
+// The length must be a multiple of HUGE_PAGE_SIZE, see HugePageLength
+void* MapHuge(size_t, uint32_t&, uintptr_t = 0u);
+
+size_t HugePageLength(size_t);
+
+const char* PageModeName(uint32_t);
+
+void* MapFile(int, size_t);
+
 int Protect(void*, size_t);
 
+int ProtectWriteExecute(void*, size_t);
+
 int Unmap(void*, size_t);
 
 }
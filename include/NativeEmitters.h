@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rbrown {
+
+class EmitterX64;
+class RecompilerState;
+
+// Native implementations of instructions for relocatable blocks
+void EmitRaiseException(RecompilerState&, EmitterX64&, uint32_t);
+void EmitInterpreterFallback(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSetBranchDelaySlot(EmitterX64&, bool);
+void EmitFlushHiLo(RecompilerState&, EmitterX64&);
+
+// Guest register access through the loop register cache, see RecompilerState::GetHostRegister
+// Flushes only write back the cached registers stored to since they were last loaded
+void EmitLoadRegister(const RecompilerState&, EmitterX64&, uint32_t, uint32_t);
+void EmitStoreRegister(RecompilerState&, EmitterX64&, uint32_t, uint32_t);
+void EmitFillRegisterCache(RecompilerState&, EmitterX64&);
+void EmitFlushRegisterCache(const RecompilerState&, EmitterX64&);
+
+void EmitSll(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSrl(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSra(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSllv(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSrlv(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSrav(RecompilerState&, EmitterX64&, uint32_t);
+void EmitAdd(RecompilerState&, EmitterX64&, uint32_t);
+void EmitAddu(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSub(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSubu(RecompilerState&, EmitterX64&, uint32_t);
+void EmitAnd(RecompilerState&, EmitterX64&, uint32_t);
+void EmitOr(RecompilerState&, EmitterX64&, uint32_t);
+void EmitXor(RecompilerState&, EmitterX64&, uint32_t);
+void EmitNor(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSlt(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSltu(RecompilerState&, EmitterX64&, uint32_t);
+void EmitMfhi(RecompilerState&, EmitterX64&, uint32_t);
+void EmitMthi(RecompilerState&, EmitterX64&, uint32_t);
+void EmitMflo(RecompilerState&, EmitterX64&, uint32_t);
+void EmitMtlo(RecompilerState&, EmitterX64&, uint32_t);
+void EmitMult(RecompilerState&, EmitterX64&, uint32_t);
+void EmitMultu(RecompilerState&, EmitterX64&, uint32_t);
+void EmitDiv(RecompilerState&, EmitterX64&, uint32_t);
+void EmitDivu(RecompilerState&, EmitterX64&, uint32_t);
+void EmitAddi(RecompilerState&, EmitterX64&, uint32_t);
+void EmitAddiu(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSlti(RecompilerState&, EmitterX64&, uint32_t);
+void EmitSltiu(RecompilerState&, EmitterX64&, uint32_t);
+void EmitAndi(RecompilerState&, EmitterX64&, uint32_t);
+void EmitOri(RecompilerState&, EmitterX64&, uint32_t);
+void EmitXori(RecompilerState&, EmitterX64&, uint32_t);
+void EmitLui(RecompilerState&, EmitterX64&, uint32_t);
+void EmitCop2Command(RecompilerState&, EmitterX64&, uint32_t);
+
+}
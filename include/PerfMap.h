@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rbrown {
+
+// Names compiled code for perf so samples in the code buffer aren't unknown
+// Every block and trace gets a line in /tmp/perf-<pid>.map, all perf report needs
+// With jitdump the code bytes are also written to jit-<pid>.dump so that after
+// perf inject --jit the code can be disassembled by perf annotate
+class PerfMap {
+public:
+    explicit PerfMap(bool);
+    ~PerfMap();
+    PerfMap(const PerfMap&) = delete;
+    PerfMap& operator=(const PerfMap&) = delete;
+    void RecordBlock(uint32_t, uintptr_t, size_t);
+    void RecordTrace(uint32_t, uintptr_t, size_t);
+private:
+    void Record(const char*, uintptr_t, size_t);
+    void WriteJitDumpHeader();
+    int mapFile;
+    int dumpFile;
+    void* marker;
+    uint64_t codeIndex;
+};
+
+}
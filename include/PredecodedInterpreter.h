@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace rbrown {
+
+class R3051;
+
+struct DecodedInstruction {
+    uint8_t handler;
+    uint8_t rs;
+    uint8_t rt;
+    uint8_t rd;
+    uint32_t immediate;
+};
+
+constexpr uint32_t DECODED_PAGE_SIZE = 4096u;
+constexpr uint32_t DECODED_PAGE_INSTRUCTIONS = DECODED_PAGE_SIZE / sizeof(uint32_t);
+
+struct DecodedPage {
+    DecodedInstruction instructions[DECODED_PAGE_INSTRUCTIONS];
+};
+
+// An interpreter that decodes each page of guest code once and then
+// dispatches on the decoded records with a computed goto
+// The integer ALU, branches, loads and stores have handlers of their own and
+// everything else, including any exception, runs through the decoder's interpreter
+// function with the load and branch delay state handed over to the processor
+class PredecodedInterpreter {
+public:
+    explicit PredecodedInterpreter(R3051&);
+    uint32_t Run(uint32_t);
+    void Invalidate(uint32_t, uint32_t);
+private:
+    const DecodedPage& Page(uint32_t);
+    R3051& processor;
+    std::unordered_map<uint32_t, std::unique_ptr<DecodedPage>> pages;
+};
+
+DecodedInstruction Decode(uint32_t);
+
+}
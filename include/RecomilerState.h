@@ -4,6 +4,9 @@
 
 namespace rbrown {
 
+// Marks a guest register that lives in the processor rather than a host register
+constexpr uint32_t NO_HOST_REGISTER = 0xFFFFFFFFu;
+
 class RecompilerState {
 public:
     explicit RecompilerState(uint32_t startPc);
@@ -13,6 +16,9 @@ public:
     [[nodiscard]] uint32_t GetBranchTarget() const;
     [[nodiscard]] bool GetBranchDelaySlot() const;
     [[nodiscard]] bool GetBranchDelaySlotNext() const;
+    [[nodiscard]] bool GetHiLoCached() const;
+    [[nodiscard]] uint32_t GetHostRegister(uint32_t) const;
+    [[nodiscard]] bool GetHostRegisterDirty(uint32_t) const;
     [[nodiscard]] uint32_t GetPC() const;
 
     void SetLoadDelayRegister(uint32_t v);
@@ -21,6 +27,9 @@ public:
     void SetBranchTarget(uint32_t v);
     void SetBranchDelaySlot(bool v);
     void SetBranchDelaySlotNext(bool v);
+    void SetHiLoCached(bool v);
+    void SetHostRegister(uint32_t guest, uint32_t host);
+    void SetHostRegisterDirty(uint32_t guest, bool v);
     void SetPC(uint32_t);
 private:
     uint32_t loadDelayRegister;
@@ -29,6 +38,10 @@ private:
     uint32_t branchTarget;
     bool branchDelaySlot;
     bool branchDelaySlotNext;
+    bool hiLoCached;
+    uint32_t hostRegisters[32];
+    // One bit per guest register whose host register is newer than the processor's copy
+    uint32_t dirtyRegisters;
     uint32_t pc;
 };
 
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CodeCache.h"
+
+namespace rbrown {
+
+// Compiles the guest code at the given PC up to and including the delay slot
+// of the first branch using the native emitter of each instruction where there
+// is one and its interpreter function where there isn't
+// Matches BlockCompiler so it can be handed straight to a CodeCache
+uint32_t Recompile(EmitterX64&, const Memory&, uint32_t);
+
+// Compiles the blocks starting at each PC of a hot path into a single superblock
+// Each branch is followed by a side exit back to the dispatcher for when it
+// doesn't go to the next block on the path
+// Returns the blocks the trace covers, none if the path was too short to be worth it
+// Matches TraceCompiler so it can be handed straight to a CodeCache
+std::vector<TraceBlock> RecompileTrace(EmitterX64&, const Memory&, const std::vector<uint32_t>&);
+
+}
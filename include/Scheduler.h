@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace rbrown {
+
+class R3051;
+
+// Called with its context and the cycle the event was due on
+using EventCallback = void (*)(void*, uint64_t);
+
+struct ScheduledEvent {
+    uint64_t due;
+    uint32_t id;
+    EventCallback callback;
+    void* context;
+};
+
+// Timed events for devices such as timers, VBlank and DMA completion
+// Events are kept in a min-heap on the cycle they are due and the processor
+// counts down the cycles to the earliest one, so compiled code only ever
+// subtracts from a counter and the heap is looked at when it runs out
+class Scheduler {
+public:
+    explicit Scheduler(R3051&);
+    [[nodiscard]] uint64_t Now() const;
+    uint32_t Schedule(uint64_t, EventCallback, void*);
+    void Cancel(uint32_t);
+    void RunEvents();
+private:
+    void StartSlice();
+    R3051& processor;
+    std::vector<ScheduledEvent> events;
+    uint64_t sliceStart;
+    int32_t sliceLength;
+    uint32_t nextId;
+};
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rbrown {
+
+class R3051;
+
+// Handlers specialised on their register operands at compile time
+// The register file is passed directly so every access is a constant offset
+// Only ADDIU, ADDU and SUBU are specialised, everything else is handed to the
+// decoder's interpreter function through the processor with the opcode as the operand
+// This is an experiment measured by example 15 and not yet used by any interpreter,
+// the handlers leave load and branch delay slots to the caller
+using SpecializedHandler = void (*)(R3051*, uint32_t*, uint32_t);
+
+struct SpecializedInstruction {
+    SpecializedHandler handler;
+    uint32_t operand;
+};
+
+SpecializedInstruction Specialize(uint32_t);
+
+}
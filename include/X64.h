@@ -12,5 +12,13 @@ constexpr uint32_t RSP = 4;
 constexpr uint32_t RBP = 5;
 constexpr uint32_t RSI = 6;
 constexpr uint32_t RDI = 7;
+constexpr uint32_t R8 = 8;
+constexpr uint32_t R9 = 9;
+constexpr uint32_t R10 = 10;
+constexpr uint32_t R11 = 11;
+constexpr uint32_t R12 = 12;
+constexpr uint32_t R13 = 13;
+constexpr uint32_t R14 = 14;
+constexpr uint32_t R15 = 15;
 
 }
@@ -8,6 +8,34 @@ void Example7();
 void Example8();
 void Example9();
 void Example10();
+void Example11();
+void Example12();
+void Example13();
+void Example14();
+void Example15();
+void Example16();
+void Example17();
+void Example18();
+void Example19();
+void Example20();
+void Example21();
+void Example22();
+void Example23();
+void Example24();
+void Example25();
+void Example26();
+void Example27();
+void Example28();
+void Example29();
+void Example30();
+void Example31();
+void Example32();
+void Example33();
+void Example34();
+void Example35();
+void Example36();
+void Example37();
+void Example38();
 
 int main() {
     Example1();
@@ -20,5 +48,33 @@ int main() {
     Example8();
     Example9();
     Example10();
+    Example11();
+    Example12();
+    Example13();
+    Example14();
+    Example15();
+    Example16();
+    Example17();
+    Example18();
+    Example19();
+    Example20();
+    Example21();
+    Example22();
+    Example23();
+    Example24();
+    Example25();
+    Example26();
+    Example27();
+    Example28();
+    Example29();
+    Example30();
+    Example31();
+    Example32();
+    Example33();
+    Example34();
+    Example35();
+    Example36();
+    Example37();
+    Example38();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include "Bios.h"
+#include "Memory.h"
+#include "MIPS.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+namespace rbrown {
+
+namespace {
+
+constexpr uint32_t FUNCTION_REGISTER = 9u;
+constexpr uint32_t RESULT_REGISTER = 2u;
+constexpr uint32_t RETURN_ADDRESS_REGISTER = 31u;
+
+constexpr uint32_t BIOS_VECTOR_MASK = 0x1FFFFFFFu;
+
+// Handles returned by OpenEvent carry the index of the event in their low bits
+constexpr uint32_t EVENT_HANDLE = 0xF1000000u;
+constexpr uint32_t EVENT_INDEX_MASK = 0x0000FFFFu;
+
+constexpr uint32_t TTY_INPUT = 0u;
+constexpr uint32_t TTY_OUTPUT = 1u;
+constexpr uint32_t FIRST_FILE_DESCRIPTOR = 2u;
+constexpr uint32_t FAILED = 0xFFFFFFFFu;
+
+uint32_t Argument(const R3051& r3051, uint32_t n) {
+    return r3051.ReadRegister(4u + n);
+}
+
+std::string ReadString(const Memory& memory, uint32_t address) {
+    std::string string;
+    for (uint32_t c = memory.ReadByte(address); c != 0u; c = memory.ReadByte(++address)) {
+        string.push_back(static_cast<char>(c));
+    }
+    return string;
+}
+
+void WriteString(Memory& memory, uint32_t address, const std::string& string) {
+    for (const char c : string) {
+        memory.WriteByte(address++, static_cast<uint8_t>(c));
+    }
+    memory.WriteByte(address, 0u);
+}
+
+void MoveBytes(Memory& memory, uint32_t destination, uint32_t source, uint32_t length) {
+    // Copies backwards when the destination overlaps the end of the source
+    if (destination > source && destination < source + length) {
+        for (uint32_t i = length; i > 0u; --i) {
+            memory.WriteByte(destination + i - 1u, memory.ReadByte(source + i - 1u));
+        }
+        return;
+    }
+    for (uint32_t i = 0u; i < length; ++i) {
+        memory.WriteByte(destination + i, memory.ReadByte(source + i));
+    }
+}
+
+uint32_t Compare(const std::string& a, const std::string& b) {
+    const int result = a.compare(b);
+    return static_cast<uint32_t>(result < 0 ? -1 : result > 0 ? 1 : 0);
+}
+
+}
+
+Bios::Bios() :
+    console { },
+    events { },
+    images { },
+    files { },
+    nextDescriptor { FIRST_FILE_DESCRIPTOR } {}
+
+bool Bios::Call(R3051& r3051, uint32_t vector) {
+    const uint32_t function = r3051.ReadRegister(FUNCTION_REGISTER);
+    bool handled = false;
+    switch (vector & BIOS_VECTOR_MASK) {
+        case BIOS_A0:
+            handled = CallA0(r3051, function);
+            break;
+        case BIOS_B0:
+            handled = CallB0(r3051, function);
+            break;
+        default:
+            break;
+    }
+    if (handled) {
+        r3051.WritePC(r3051.ReadRegister(RETURN_ADDRESS_REGISTER));
+    }
+    return handled;
+}
+
+void Bios::AddFile(const std::string& name, std::vector<uint8_t> image) {
+    images[name] = std::move(image);
+}
+
+void Bios::DeliverEvent(uint32_t eventClass, uint32_t spec) {
+    // Events that would call a handler are only marked ready, the handler
+    // is guest code and can't be run from here
+    for (BiosEvent& event : events) {
+        if (event.open && event.enabled && event.eventClass == eventClass && event.spec == spec) {
+            event.ready = true;
+        }
+    }
+}
+
+const std::string& Bios::Console() const { return console; }
+
+bool Bios::CallA0(R3051& r3051, uint32_t function) {
+    Memory& memory = *r3051.GetMemory();
+    const uint32_t a0 = Argument(r3051, 0u);
+    const uint32_t a1 = Argument(r3051, 1u);
+    const uint32_t a2 = Argument(r3051, 2u);
+    uint32_t result;
+    switch (function) {
+        case 0x15u:
+            WriteString(memory, a0, ReadString(memory, a0) + ReadString(memory, a1));
+            result = a0;
+            break;
+        case 0x17u:
+            result = Compare(ReadString(memory, a0), ReadString(memory, a1));
+            break;
+        case 0x19u:
+            WriteString(memory, a0, ReadString(memory, a1));
+            result = a0;
+            break;
+        case 0x1Bu:
+            result = static_cast<uint32_t>(ReadString(memory, a0).size());
+            break;
+        case 0x25u:
+            result = static_cast<uint32_t>(std::toupper(static_cast<int>(a0 & 0xFFu)));
+            break;
+        case 0x26u:
+            result = static_cast<uint32_t>(std::tolower(static_cast<int>(a0 & 0xFFu)));
+            break;
+        case 0x2Au:
+        case 0x2Cu:
+            MoveBytes(memory, a0, a1, a2);
+            result = a0;
+            break;
+        case 0x2Bu:
+            for (uint32_t i = 0u; i < a2; ++i) {
+                memory.WriteByte(a0 + i, a1 & 0xFFu);
+            }
+            result = a0;
+            break;
+        case 0x3Cu:
+            console.push_back(static_cast<char>(a0));
+            result = a0;
+            break;
+        case 0x3Eu:
+            console += ReadString(memory, a0);
+            console.push_back('\n');
+            result = 0u;
+            break;
+        default:
+            return false;
+    }
+    r3051.WriteRegister(RESULT_REGISTER, result);
+    return true;
+}
+
+bool Bios::CallB0(R3051& r3051, uint32_t function) {
+    Memory& memory = *r3051.GetMemory();
+    const uint32_t a0 = Argument(r3051, 0u);
+    const uint32_t a1 = Argument(r3051, 1u);
+    const uint32_t a2 = Argument(r3051, 2u);
+    uint32_t result = 1u;
+    BiosEvent* event = nullptr;
+    switch (function) {
+        case 0x07u:
+            DeliverEvent(a0, a1);
+            break;
+        case 0x08u:
+            result = OpenEvent(a0, a1, a2);
+            break;
+        case 0x09u:
+        case 0x0Cu:
+        case 0x0Du:
+            event = FindEvent(a0);
+            if (!event) {
+                result = 0u;
+            } else if (function == 0x09u) {
+                event->open = false;
+            } else {
+                event->enabled = function == 0x0Cu;
+            }
+            break;
+        case 0x0Au:
+        case 0x0Bu:
+            // WaitEvent can't block the guest from here so it reports the same as TestEvent
+            event = FindEvent(a0);
+            result = event && event->ready ? 1u : 0u;
+            if (event) {
+                event->ready = false;
+            }
+            break;
+        case 0x32u:
+            result = OpenFile(r3051, a0);
+            break;
+        case 0x34u:
+            result = ReadFile(r3051, a0, a1, a2);
+            break;
+        case 0x35u:
+            result = WriteFile(r3051, a0, a1, a2);
+            break;
+        case 0x36u:
+            result = CloseFile(a0);
+            break;
+        case 0x3Du:
+            console.push_back(static_cast<char>(a0));
+            result = a0;
+            break;
+        case 0x3Fu:
+            console += ReadString(memory, a0);
+            console.push_back('\n');
+            result = 0u;
+            break;
+        default:
+            return false;
+    }
+    r3051.WriteRegister(RESULT_REGISTER, result);
+    return true;
+}
+
+uint32_t Bios::OpenEvent(uint32_t eventClass, uint32_t spec, uint32_t mode) {
+    // Closed events are reused before the table grows
+    const auto free = std::find_if(events.begin(), events.end(), [](const BiosEvent& e) { return !e.open; });
+    const BiosEvent event { eventClass, spec, mode, true, false, false };
+    if (free != events.end()) {
+        *free = event;
+        return EVENT_HANDLE | static_cast<uint32_t>(free - events.begin());
+    }
+    events.push_back(event);
+    return EVENT_HANDLE | static_cast<uint32_t>(events.size() - 1u);
+}
+
+BiosEvent* Bios::FindEvent(uint32_t handle) {
+    const uint32_t index = handle & EVENT_INDEX_MASK;
+    if ((handle & ~EVENT_INDEX_MASK) != EVENT_HANDLE || index >= events.size() || !events[index].open) {
+        return nullptr;
+    }
+    return &events[index];
+}
+
+uint32_t Bios::OpenFile(R3051& r3051, uint32_t name) {
+    const std::string path = ReadString(*r3051.GetMemory(), name);
+    if (images.count(path) == 0u) {
+        return FAILED;
+    }
+    const uint32_t descriptor = nextDescriptor++;
+    files[descriptor] = BiosFile { path, 0u };
+    return descriptor;
+}
+
+uint32_t Bios::ReadFile(R3051& r3051, uint32_t descriptor, uint32_t destination, uint32_t length) {
+    const auto file = files.find(descriptor);
+    if (file == files.end()) {
+        return descriptor == TTY_INPUT ? 0u : FAILED;
+    }
+    const std::vector<uint8_t>& image = images[file->second.name];
+    const uint32_t available = static_cast<uint32_t>(image.size()) - std::min(file->second.position, static_cast<uint32_t>(image.size()));
+    const uint32_t count = std::min(length, available);
+    Memory& memory = *r3051.GetMemory();
+    for (uint32_t i = 0u; i < count; ++i) {
+        memory.WriteByte(destination + i, image[file->second.position + i]);
+    }
+    file->second.position += count;
+    return count;
+}
+
+uint32_t Bios::WriteFile(R3051& r3051, uint32_t descriptor, uint32_t source, uint32_t length) {
+    // Files added by the host are read only
+    if (descriptor != TTY_OUTPUT) {
+        return FAILED;
+    }
+    const Memory& memory = *r3051.GetMemory();
+    for (uint32_t i = 0u; i < length; ++i) {
+        console.push_back(static_cast<char>(memory.ReadByte(source + i)));
+    }
+    return length;
+}
+
+uint32_t Bios::CloseFile(uint32_t descriptor) {
+    return files.erase(descriptor) != 0u ? descriptor : FAILED;
+}
+
+bool IsBiosVector(uint32_t pc) {
+    const uint32_t physical = pc & BIOS_VECTOR_MASK;
+    return physical == BIOS_A0 || physical == BIOS_B0 || physical == BIOS_C0;
+}
+
+void CallBios(R3051* r3051, uint32_t vector) {
+    // The jump here may have left a load in its delay slot, it is written back
+    // first so that the function sees the arguments and number it was given
+    RetireLoad(r3051);
+    if (Bios* bios = r3051->GetBios()) {
+        bios->Call(*r3051, vector);
+    }
+}
+
+}
@@ -0,0 +1,67 @@
+#include "BlockAbi.h"
+#include "CodeBuffer.h"
+#include "EmitterX64.h"
+#include "HelperTable.h"
+#include "MIPS.h"
+
+namespace rbrown {
+
+namespace {
+
+// RBP, RBX, R13, R14 and R15 are pushed by the prologue
+constexpr uint8_t SAVED_REGISTERS_OFFSET = -32;
+
+}
+
+void EmitBlockPrologue(EmitterX64& emitter) {
+    // Entry RSP is 8 mod 16, five pushes leave it 16 byte aligned
+    emitter.PushR64(RBP);
+    emitter.MovR64R64(RBP, RSP);
+    emitter.PushR64(CONTEXT);
+    emitter.PushR64(HELPERS);
+    emitter.PushR64(HOST_LO);
+    emitter.PushR64(HOST_HI);
+    emitter.MovR64R64(CONTEXT, RDI);
+    emitter.MovR64R64(HELPERS, RSI);
+}
+
+void EmitBlockEpilogue(EmitterX64& emitter) {
+    emitter.LeaR64Disp8(RSP, RBP, SAVED_REGISTERS_OFFSET);
+    emitter.PopR64(HOST_HI);
+    emitter.PopR64(HOST_LO);
+    emitter.PopR64(HELPERS);
+    emitter.PopR64(CONTEXT);
+    emitter.PopR64(RBP);
+    emitter.Ret();
+}
+
+void EmitCallHelper(EmitterX64& emitter, uint32_t helper) {
+    const uint32_t offset = HelperTable::Offset(helper);
+    if (offset < 0x80u) {
+        emitter.CallDisp8(HELPERS, static_cast<uint8_t>(offset));
+    } else {
+        emitter.CallDisp32(HELPERS, offset);
+    }
+}
+
+void EmitLoadGuestRegister(EmitterX64& emitter, uint32_t host, uint32_t guest) {
+    emitter.MovR32Disp8(host, CONTEXT, static_cast<uint8_t>(R3051::RegisterOffset(guest)));
+}
+
+void EmitStoreGuestRegister(EmitterX64& emitter, uint32_t guest, uint32_t host) {
+    // Writes to $zero are discarded
+    if (guest == 0u) {
+        return;
+    }
+    emitter.MovDisp8R32(CONTEXT, static_cast<uint8_t>(R3051::RegisterOffset(guest)), host);
+}
+
+void EmitStorePC(EmitterX64& emitter, uint32_t pc) {
+    emitter.MovDisp32Imm32(CONTEXT, static_cast<uint32_t>(R3051::PCOffset()), pc);
+}
+
+CompiledBlock BlockAt(const CodeBuffer& buffer, size_t position) {
+    return reinterpret_cast<CompiledBlock>(buffer.BufferAddress() + position);
+}
+
+}
@@ -0,0 +1,133 @@
+#include "BlockProfiler.h"
+#include "Decoder.h"
+#include "EmitterX64.h"
+#include "Memory.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace rbrown {
+
+namespace {
+
+using ProfileOrder = bool (*)(const BlockProfile*, const BlockProfile*);
+
+std::vector<const BlockProfile*> Top(const std::deque<BlockProfile>& profiles, size_t n, ProfileOrder order) {
+    std::vector<const BlockProfile*> top;
+    top.reserve(profiles.size());
+    for (const BlockProfile& profile : profiles) {
+        top.push_back(&profile);
+    }
+    n = std::min(n, top.size());
+    std::partial_sort(top.begin(), top.begin() + n, top.end(), order);
+    top.resize(n);
+    return top;
+}
+
+uint8_t CyclesOffset(const BlockProfile* profile) {
+    return static_cast<uint8_t>(AddressOf(profile->cycles) - AddressOf(profile->count));
+}
+
+void EmitReadTimestamp(EmitterX64& emitter) {
+    emitter.Rdtsc();
+    emitter.ShlR64Imm8(RDX, 32u);
+    emitter.OrR64R64(RAX, RDX);
+}
+
+template<typename... Args>
+void AppendLine(std::string& report, const char* format, Args... args) {
+    char line[128];
+    std::snprintf(line, sizeof(line), format, args...);
+    report += line;
+}
+
+void AppendProfiles(std::string& report, const Memory& memory, const std::vector<const BlockProfile*>& top) {
+    for (const BlockProfile* profile : top) {
+        const uint32_t pc = profile->blocks.front().pc;
+        AppendLine(report, "%s 0x%08x count %" PRIu64 " cycles %" PRIu64 " host 0x%" PRIxPTR " %zu bytes\n",
+                   profile->blocks.size() > 1u ? "trace" : "block", pc,
+                   profile->count, profile->cycles, profile->code, profile->size);
+        for (const TraceBlock& block : profile->blocks) {
+            for (uint32_t i = 0u; i < block.length; ++i) {
+                const uint32_t address = block.pc + 4u * i;
+                const uint32_t opcode = memory.ReadWord(address);
+                AppendLine(report, "    0x%08x  %08x  %s\n", address, opcode,
+                           DisassembleInstruction(address, opcode).c_str());
+            }
+        }
+    }
+}
+
+}
+
+BlockProfiler::BlockProfiler(bool t) :
+    timing { t },
+    profiles { } {
+}
+
+bool BlockProfiler::Timing() const { return timing; }
+
+size_t BlockProfiler::ProfileCount() const { return profiles.size(); }
+
+BlockProfile* BlockProfiler::Allocate() {
+    return &profiles.emplace_back(BlockProfile { 0u, 0u, { }, 0u, 0u });
+}
+
+void BlockProfiler::EmitCounter(EmitterX64& emitter, BlockProfile* profile) const {
+    // RAX is free on entry, the prologue that follows saves everything else
+    emitter.MovR64Literal(RAX, AddressOf(profile->count));
+    emitter.IncQwordDisp8(RAX, 0u);
+}
+
+void BlockProfiler::EmitEntry(EmitterX64& emitter, BlockProfile* profile, CompiledBlock block) const {
+    if (!timing) {
+        EmitCounter(emitter, profile);
+        emitter.Jmp(reinterpret_cast<uintptr_t>(block));
+        return;
+    }
+    // Blocks leave through several epilogues, so rather than time each exit
+    // the block is called from a stub that reads the timestamp either side
+    // RBX and R12 survive the call and keep the profile and the start time
+    emitter.PushR64(RBX);
+    emitter.PushR64(R12);
+    emitter.SubR64Imm8(RSP, 8u);
+    emitter.MovR64Literal(RBX, AddressOf(profile->count));
+    emitter.IncQwordDisp8(RBX, 0u);
+    EmitReadTimestamp(emitter);
+    emitter.MovR64R64(R12, RAX);
+    emitter.Call(reinterpret_cast<uintptr_t>(block));
+    EmitReadTimestamp(emitter);
+    emitter.SubR64R64(RAX, R12);
+    emitter.AddDisp8R64(RBX, CyclesOffset(profile), RAX);
+    emitter.AddR64Imm8(RSP, 8u);
+    emitter.PopR64(R12);
+    emitter.PopR64(RBX);
+    emitter.Ret();
+}
+
+std::vector<const BlockProfile*> BlockProfiler::TopByCount(size_t n) const {
+    return Top(profiles, n, [](const BlockProfile* a, const BlockProfile* b) {
+        return a->count > b->count;
+    });
+}
+
+std::vector<const BlockProfile*> BlockProfiler::TopByCycles(size_t n) const {
+    return Top(profiles, n, [](const BlockProfile* a, const BlockProfile* b) {
+        return a->cycles > b->cycles;
+    });
+}
+
+std::string BlockProfiler::Report(const Memory& memory, size_t n) const {
+    // Guest code is read back now, so blocks since overwritten show the new code
+    std::string report;
+    AppendLine(report, "top %zu of %zu blocks by count\n", n, profiles.size());
+    AppendProfiles(report, memory, TopByCount(n));
+    if (timing) {
+        AppendLine(report, "top %zu of %zu blocks by host cycles\n", n, profiles.size());
+        AppendProfiles(report, memory, TopByCycles(n));
+    }
+    return report;
+}
+
+}
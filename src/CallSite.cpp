@@ -2,8 +2,12 @@
 
 namespace rbrown {
 
-CallSite::CallSite(size_t v) : position(v) {}
+CallSite::CallSite(size_t v) : position(v), wide(false) {}
+
+CallSite::CallSite(size_t v, bool w) : position(v), wide(w) {}
 
 size_t CallSite::Position() const { return position; }
 
+bool CallSite::Wide() const { return wide; }
+
 }
\ No newline at end of file
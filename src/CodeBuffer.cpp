@@ -1,19 +1,36 @@
 #include "CodeBuffer.h"
 #include "Mmap.h"
 
+#include <cassert>
+
 namespace rbrown {
 
-CodeBuffer::CodeBuffer(size_t len) : buffer(rbrown::xmmap::Map(len)), length(len), pos(0) {}
+CodeBuffer::CodeBuffer(size_t len, bool huge) :
+    buffer(nullptr),
+    mapped(huge ? rbrown::xmmap::HugePageLength(len + VENEER_ISLAND_SIZE) : len + VENEER_ISLAND_SIZE),
+    length(mapped - VENEER_ISLAND_SIZE),
+    pos(0),
+    pageMode(rbrown::xmmap::PAGES_SMALL),
+    veneerTop(mapped),
+    veneers() {
+    const uintptr_t anchor = rbrown::xmmap::ExecutableAddress();
+    buffer = huge ? rbrown::xmmap::MapHuge(mapped, pageMode, anchor) : rbrown::xmmap::MapNear(mapped, anchor);
+}
 
 CodeBuffer::~CodeBuffer() {
-    rbrown::xmmap::Unmap(buffer, length);
+    rbrown::xmmap::Unmap(buffer, mapped);
     buffer = nullptr;
+    mapped = 0;
     length = 0;
     pos = 0;
 }
 
 void CodeBuffer::Protect() {
-    rbrown::xmmap::Protect(buffer, length);
+    rbrown::xmmap::Protect(buffer, mapped);
+}
+
+void CodeBuffer::ProtectWriteExecute() {
+    rbrown::xmmap::ProtectWriteExecute(buffer, mapped);
 }
 
 void CodeBuffer::Call() {
@@ -28,11 +45,47 @@ size_t CodeBuffer::Position() const {
     return pos;
 }
 
+size_t CodeBuffer::Length() const {
+    return length;
+}
+
+uint32_t CodeBuffer::PageMode() const {
+    return pageMode;
+}
+
+uintptr_t CodeBuffer::Veneer(uintptr_t target) {
+    // Returns zero once the island is full
+    if (const auto it = veneers.find(target); it != veneers.end()) {
+        return BufferAddress() + it->second;
+    }
+    if (veneerTop - VENEER_SIZE < length) {
+        return 0u;
+    }
+    veneerTop -= VENEER_SIZE;
+    // jmp [rip+2], padding, then the target itself
+    size_t position = veneerTop;
+    for (const uint8_t b : { 0xFFu, 0x25u, 0x02u, 0x00u, 0x00u, 0x00u, 0xCCu, 0xCCu }) {
+        Byte(position++, b);
+    }
+    for (size_t i = 0u; i < sizeof(target); ++i) {
+        Byte(position++, static_cast<uint8_t>(target >> (8u * i)));
+    }
+    veneers.emplace(target, veneerTop);
+    return BufferAddress() + veneerTop;
+}
+
+size_t CodeBuffer::VeneerCount() const {
+    return veneers.size();
+}
+
 void CodeBuffer::Byte(uint8_t b) {
+    // Code must stay clear of the veneer island
+    assert(pos < length);
     *(reinterpret_cast<uint8_t*>(buffer) + (pos++)) = b;
 }
 
 void CodeBuffer::Byte(size_t position, uint8_t b) {
+    assert(position < mapped);
     *(reinterpret_cast<uint8_t*>(buffer) + position) = b;
 }
 
@@ -50,6 +103,12 @@ void CodeBuffer::DWord(uint32_t v) {
     Word(uint16_t(v >> 16u));
 }
 
+void CodeBuffer::DWord(size_t position, uint32_t v) {
+    for (size_t i = 0u; i < sizeof(v); ++i) {
+        Byte(position + i, static_cast<uint8_t>(v >> (8u * i)));
+    }
+}
+
 void CodeBuffer::QWord(uint64_t v) {
     DWord(uint32_t(v));
     DWord(uint32_t(v >> 32u));
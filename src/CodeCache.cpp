@@ -0,0 +1,229 @@
+#include "CodeCache.h"
+#include "BlockProfiler.h"
+#include "Decoder.h"
+#include "EmitterX64.h"
+#include "GdbJit.h"
+#include "JitStats.h"
+#include "Memory.h"
+#include "PerfMap.h"
+
+#include <chrono>
+#include <mutex>
+#include <utility>
+
+namespace rbrown {
+
+namespace {
+
+// Instructions the compiler can only call the interpreter for
+uint64_t CountFallbacks(const Memory& memory, uint32_t pc, uint32_t length) {
+    uint64_t fallbacks = 0u;
+    for (uint32_t i = 0u; i < length; ++i) {
+        if (!DecodeInstruction(memory.ReadWord(pc + 4u * i)).emit) {
+            ++fallbacks;
+        }
+    }
+    return fallbacks;
+}
+
+uint64_t Nanoseconds(std::chrono::steady_clock::time_point start) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+// Where each way out of the code just emitted returns from its frame
+std::vector<uintptr_t> ReturnAddresses(const CodeBuffer& buffer, const EmitterX64& emitter) {
+    std::vector<uintptr_t> returns;
+    for (const size_t position : emitter.Returns()) {
+        returns.push_back(buffer.BufferAddress() + position);
+    }
+    return returns;
+}
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325u;
+constexpr uint64_t FNV_PRIME = 0x100000001B3u;
+
+}
+
+uint64_t HashGuestCode(const Memory& memory, uint32_t pc, uint32_t length) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (uint32_t i = 0u; i < length; ++i) {
+        hash = (hash ^ memory.ReadWord(pc + 4u * i)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+CodeCache::CodeCache(size_t length, BlockCompiler c, TraceCompiler t, bool hugePages) :
+    buffer { length, hugePages },
+    helpers { },
+    compiler { c },
+    traceCompiler { t },
+    perfMap { nullptr },
+    gdbJit { nullptr },
+    profiler { nullptr },
+    stats { nullptr },
+    mutex { },
+    blocks { } {
+    // Blocks are appended while other threads are executing earlier ones
+    buffer.ProtectWriteExecute();
+}
+
+const HelperTable& CodeCache::Helpers() const { return helpers; }
+
+size_t CodeCache::BlockCount() const {
+    std::shared_lock lock(mutex);
+    return blocks.size();
+}
+
+uint32_t CodeCache::PageMode() const { return buffer.PageMode(); }
+
+const CachedBlock* CodeCache::Find(const Memory& memory, uint32_t pc) const {
+    auto [first, last] = blocks.equal_range(pc);
+    for (auto it = first; it != last; ++it) {
+        const CachedBlock& block = it->second;
+        if (HashGuestCode(memory, pc, block.length) == block.hash) {
+            return &block;
+        }
+    }
+    return nullptr;
+}
+
+CachedBlock CodeCache::Lookup(const Memory& memory, uint32_t pc) {
+    {
+        std::shared_lock lock(mutex);
+        if (const CachedBlock* block = Find(memory, pc)) {
+            return *block;
+        }
+    }
+    std::unique_lock lock(mutex);
+    // Another thread may have compiled this block while we waited
+    if (const CachedBlock* block = Find(memory, pc)) {
+        return *block;
+    }
+    if (buffer.Length() - buffer.Position() < MAX_BLOCK_SIZE) {
+        return CachedBlock { pc, 0u, 0u, nullptr };
+    }
+    const size_t position = buffer.Position();
+    EmitterX64 emitter(buffer);
+    BlockProfile* profile = profiler ? profiler->Allocate() : nullptr;
+    if (profile && !profiler->Timing()) {
+        profiler->EmitCounter(emitter, profile);
+    }
+    const size_t compiled = buffer.Position();
+    const auto start = std::chrono::steady_clock::now();
+    const uint32_t length = compiler(emitter, memory, pc);
+    // Blocks only leave through their epilogues so the pool can follow straight on
+    emitter.EmitLiteralPool();
+    if (stats) {
+        stats->Record(JitCompile {
+            length, buffer.Position() - compiled, emitter.CallCount(), CountFallbacks(memory, pc, length),
+            emitter.LabelCount(), emitter.FixUpCount(), Nanoseconds(start)
+        });
+    }
+    CompiledBlock code = BlockAt(buffer, position);
+    const size_t end = buffer.Position();
+    if (profile) {
+        if (profiler->Timing()) {
+            const size_t entry = buffer.Position();
+            profiler->EmitEntry(emitter, profile, code);
+            emitter.EmitLiteralPool();
+            code = BlockAt(buffer, entry);
+        }
+        profile->blocks = { TraceBlock { pc, length } };
+        profile->code = buffer.BufferAddress() + position;
+        profile->size = buffer.Position() - position;
+    }
+    const CachedBlock block { pc, length, HashGuestCode(memory, pc, length), code };
+    if (perfMap) {
+        perfMap->RecordBlock(pc, buffer.BufferAddress() + position, buffer.Position() - position);
+    }
+    if (gdbJit) {
+        // The counter runs before the prologue and the timing entry builds a frame of its own
+        const std::vector<uintptr_t> returns = ReturnAddresses(buffer, emitter);
+        gdbJit->RecordBlock(pc, buffer.BufferAddress() + position, end - position, compiled - position, returns);
+        if (buffer.Position() != end) {
+            gdbJit->RecordEntry(pc, buffer.BufferAddress() + end, buffer.Position() - end, true, returns);
+        }
+    }
+    blocks.emplace(pc, block);
+    return block;
+}
+
+CachedTrace CodeCache::CompileTrace(const Memory& memory, const std::vector<uint32_t>& path) {
+    // Nothing is kept here, the instance that asked for the trace holds on to it
+    std::unique_lock lock(mutex);
+    if (!traceCompiler || buffer.Length() - buffer.Position() < MAX_BLOCK_SIZE * path.size()) {
+        return CachedTrace { { }, nullptr };
+    }
+    const size_t position = buffer.Position();
+    EmitterX64 emitter(buffer);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<TraceBlock> blocks = traceCompiler(emitter, memory, path);
+    if (blocks.empty()) {
+        return CachedTrace { { }, nullptr };
+    }
+    emitter.EmitLiteralPool();
+    if (stats) {
+        JitCompile compile { 0u, buffer.Position() - position, emitter.CallCount(), 0u,
+                             emitter.LabelCount(), emitter.FixUpCount(), Nanoseconds(start) };
+        for (const TraceBlock& block : blocks) {
+            compile.guestInstructions += block.length;
+            compile.fallbacks += CountFallbacks(memory, block.pc, block.length);
+        }
+        stats->Record(compile);
+    }
+    CompiledBlock code = BlockAt(buffer, position);
+    const size_t end = buffer.Position();
+    if (profiler) {
+        BlockProfile* profile = profiler->Allocate();
+        const size_t entry = buffer.Position();
+        profiler->EmitEntry(emitter, profile, code);
+        emitter.EmitLiteralPool();
+        code = BlockAt(buffer, entry);
+        profile->blocks = blocks;
+        profile->code = buffer.BufferAddress() + position;
+        profile->size = buffer.Position() - position;
+    }
+    if (perfMap) {
+        perfMap->RecordTrace(path.front(), buffer.BufferAddress() + position, buffer.Position() - position);
+    }
+    if (gdbJit) {
+        const std::vector<uintptr_t> returns = ReturnAddresses(buffer, emitter);
+        gdbJit->RecordTrace(path.front(), buffer.BufferAddress() + position, end - position, returns);
+        if (profiler) {
+            gdbJit->RecordEntry(path.front(), buffer.BufferAddress() + end, buffer.Position() - end, profiler->Timing(), returns);
+        }
+    }
+    return CachedTrace { std::move(blocks), code };
+}
+
+void CodeCache::FlushDebugInfo() {
+    // Blocks compiled during a run slice are registered with a debugger once it ends
+    std::unique_lock lock(mutex);
+    if (gdbJit) {
+        gdbJit->Flush();
+    }
+}
+
+void CodeCache::AttachPerfMap(PerfMap* map) {
+    std::unique_lock lock(mutex);
+    perfMap = map;
+}
+
+void CodeCache::AttachGdbJit(GdbJit* jit) {
+    std::unique_lock lock(mutex);
+    gdbJit = jit;
+}
+
+void CodeCache::AttachProfiler(BlockProfiler* p) {
+    // Only blocks compiled from now on are instrumented
+    std::unique_lock lock(mutex);
+    profiler = p;
+}
+
+void CodeCache::AttachStats(JitStats* s) {
+    std::unique_lock lock(mutex);
+    stats = s;
+}
+
+}
@@ -0,0 +1,252 @@
+#include "Decoder.h"
+#include "NativeEmitters.h"
+#include "MIPS.h"
+
+#include <array>
+#include <cstdio>
+
+namespace rbrown {
+
+namespace {
+
+// The decode table is laid out as consecutive subtables
+// PRIMARY indexed by op, SPECIAL by function, REGIMM by rt, COP0 and COP2 by rs
+constexpr uint32_t PRIMARY = 0u;
+constexpr uint32_t SPECIAL = 64u;
+constexpr uint32_t REGIMM = 128u;
+constexpr uint32_t COP0 = 160u;
+constexpr uint32_t COP2 = 192u;
+
+// Every op has a selector saying which subtable and field to index with
+// packed as base | shift << 16 | mask << 24
+constexpr uint32_t Selector(uint32_t base, uint32_t shift, uint32_t mask) {
+    return base | (shift << 16u) | (mask << 24u);
+}
+
+constexpr std::array<uint32_t, 64> MakeSelectors() {
+    std::array<uint32_t, 64> selectors { };
+    for (uint32_t op = 0u; op < 64u; ++op) {
+        selectors[op] = Selector(PRIMARY + op, 0u, 0u);
+    }
+    selectors[0x00] = Selector(SPECIAL, 0u, 0x3Fu);
+    selectors[0x01] = Selector(REGIMM, 16u, 0x1Fu);
+    selectors[0x10] = Selector(COP0, 21u, 0x1Fu);
+    selectors[0x12] = Selector(COP2, 21u, 0x1Fu);
+    return selectors;
+}
+
+constexpr std::array<uint32_t, 64> SELECTORS = MakeSelectors();
+
+constexpr InstructionInfo Reserved() {
+    return { "reserved", InterpretReserved, nullptr, CAN_FAULT };
+}
+
+constexpr InstructionInfo Unusable(const char* mnemonic, uint32_t flags) {
+    return { mnemonic, InterpretCoprocessorUnusable, nullptr, flags | CAN_FAULT };
+}
+
+constexpr uint32_t R_TYPE = READS_RS | READS_RT | WRITES_RD;
+constexpr uint32_t SHIFT = READS_RT | WRITES_RD;
+constexpr uint32_t I_TYPE = READS_RS | WRITES_RT;
+constexpr uint32_t LOAD = READS_RS | WRITES_RT | IS_LOAD | CAN_FAULT;
+constexpr uint32_t STORE = READS_RS | READS_RT | IS_STORE | CAN_FAULT;
+constexpr uint32_t BRANCH = READS_RS | READS_RT | IS_BRANCH;
+
+constexpr void MakePrimary(std::array<InstructionInfo, DECODE_TABLE_SIZE>& t) {
+    t[PRIMARY + 0x02] = { "j", InterpretJ, nullptr, IS_BRANCH };
+    t[PRIMARY + 0x03] = { "jal", InterpretJal, nullptr, IS_BRANCH | WRITES_RA };
+    t[PRIMARY + 0x04] = { "beq", InterpretBeq, nullptr, BRANCH };
+    t[PRIMARY + 0x05] = { "bne", InterpretBne, nullptr, BRANCH };
+    t[PRIMARY + 0x06] = { "blez", InterpretBlez, nullptr, READS_RS | IS_BRANCH };
+    t[PRIMARY + 0x07] = { "bgtz", InterpretBgtz, nullptr, READS_RS | IS_BRANCH };
+    t[PRIMARY + 0x08] = { "addi", InterpretAddi, EmitAddi, I_TYPE | CAN_FAULT };
+    t[PRIMARY + 0x09] = { "addiu", InterpretAddiu, EmitAddiu, I_TYPE };
+    t[PRIMARY + 0x0A] = { "slti", InterpretSlti, EmitSlti, I_TYPE };
+    t[PRIMARY + 0x0B] = { "sltiu", InterpretSltiu, EmitSltiu, I_TYPE };
+    t[PRIMARY + 0x0C] = { "andi", InterpretAndi, EmitAndi, I_TYPE };
+    t[PRIMARY + 0x0D] = { "ori", InterpretOri, EmitOri, I_TYPE };
+    t[PRIMARY + 0x0E] = { "xori", InterpretXori, EmitXori, I_TYPE };
+    t[PRIMARY + 0x0F] = { "lui", InterpretLui, EmitLui, WRITES_RT };
+    t[PRIMARY + 0x11] = Unusable("cop1", 0u);
+    t[PRIMARY + 0x13] = Unusable("cop3", 0u);
+    t[PRIMARY + 0x20] = { "lb", InterpretLb, nullptr, LOAD };
+    t[PRIMARY + 0x21] = { "lh", InterpretLh, nullptr, LOAD };
+    t[PRIMARY + 0x22] = { "lwl", InterpretLwl, nullptr, LOAD | READS_RT };
+    t[PRIMARY + 0x23] = { "lw", InterpretLw, nullptr, LOAD };
+    t[PRIMARY + 0x24] = { "lbu", InterpretLbu, nullptr, LOAD };
+    t[PRIMARY + 0x25] = { "lhu", InterpretLhu, nullptr, LOAD };
+    t[PRIMARY + 0x26] = { "lwr", InterpretLwr, nullptr, LOAD | READS_RT };
+    t[PRIMARY + 0x28] = { "sb", InterpretSb, nullptr, STORE };
+    t[PRIMARY + 0x29] = { "sh", InterpretSh, nullptr, STORE };
+    t[PRIMARY + 0x2A] = { "swl", InterpretSwl, nullptr, STORE };
+    t[PRIMARY + 0x2B] = { "sw", InterpretSw, nullptr, STORE };
+    t[PRIMARY + 0x2E] = { "swr", InterpretSwr, nullptr, STORE };
+    // Transfers with a missing coprocessor raise before touching memory or a register,
+    // so they are neither loads nor stores, and LWC2 writes the GTE without a load delay
+    t[PRIMARY + 0x30] = Unusable("lwc0", READS_RS);
+    t[PRIMARY + 0x31] = Unusable("lwc1", READS_RS);
+    t[PRIMARY + 0x32] = { "lwc2", InterpretLwc2, nullptr, READS_RS | CAN_FAULT };
+    t[PRIMARY + 0x33] = Unusable("lwc3", READS_RS);
+    t[PRIMARY + 0x38] = Unusable("swc0", READS_RS);
+    t[PRIMARY + 0x39] = Unusable("swc1", READS_RS);
+    t[PRIMARY + 0x3A] = { "swc2", InterpretSwc2, nullptr, READS_RS | IS_STORE | CAN_FAULT };
+    t[PRIMARY + 0x3B] = Unusable("swc3", READS_RS);
+}
+
+constexpr void MakeSpecial(std::array<InstructionInfo, DECODE_TABLE_SIZE>& t) {
+    t[SPECIAL + 0x00] = { "sll", InterpretSll, EmitSll, SHIFT };
+    t[SPECIAL + 0x02] = { "srl", InterpretSrl, EmitSrl, SHIFT };
+    t[SPECIAL + 0x03] = { "sra", InterpretSra, EmitSra, SHIFT };
+    t[SPECIAL + 0x04] = { "sllv", InterpretSllv, EmitSllv, R_TYPE };
+    t[SPECIAL + 0x06] = { "srlv", InterpretSrlv, EmitSrlv, R_TYPE };
+    t[SPECIAL + 0x07] = { "srav", InterpretSrav, EmitSrav, R_TYPE };
+    t[SPECIAL + 0x08] = { "jr", InterpretJr, nullptr, READS_RS | IS_BRANCH };
+    t[SPECIAL + 0x09] = { "jalr", InterpretJalr, nullptr, READS_RS | WRITES_RD | IS_BRANCH };
+    t[SPECIAL + 0x0C] = { "syscall", InterpretSyscall, nullptr, CAN_FAULT };
+    t[SPECIAL + 0x0D] = { "break", InterpretBreak, nullptr, CAN_FAULT };
+    t[SPECIAL + 0x10] = { "mfhi", InterpretMfhi, EmitMfhi, WRITES_RD };
+    t[SPECIAL + 0x11] = { "mthi", InterpretMthi, EmitMthi, READS_RS };
+    t[SPECIAL + 0x12] = { "mflo", InterpretMflo, EmitMflo, WRITES_RD };
+    t[SPECIAL + 0x13] = { "mtlo", InterpretMtlo, EmitMtlo, READS_RS };
+    t[SPECIAL + 0x18] = { "mult", InterpretMult, EmitMult, READS_RS | READS_RT };
+    t[SPECIAL + 0x19] = { "multu", InterpretMultu, EmitMultu, READS_RS | READS_RT };
+    t[SPECIAL + 0x1A] = { "div", InterpretDiv, EmitDiv, READS_RS | READS_RT };
+    t[SPECIAL + 0x1B] = { "divu", InterpretDivu, EmitDivu, READS_RS | READS_RT };
+    t[SPECIAL + 0x20] = { "add", InterpretAdd, EmitAdd, R_TYPE | CAN_FAULT };
+    t[SPECIAL + 0x21] = { "addu", InterpretAddu, EmitAddu, R_TYPE };
+    t[SPECIAL + 0x22] = { "sub", InterpretSub, EmitSub, R_TYPE | CAN_FAULT };
+    t[SPECIAL + 0x23] = { "subu", InterpretSubu, EmitSubu, R_TYPE };
+    t[SPECIAL + 0x24] = { "and", InterpretAnd, EmitAnd, R_TYPE };
+    t[SPECIAL + 0x25] = { "or", InterpretOr, EmitOr, R_TYPE };
+    t[SPECIAL + 0x26] = { "xor", InterpretXor, EmitXor, R_TYPE };
+    t[SPECIAL + 0x27] = { "nor", InterpretNor, EmitNor, R_TYPE };
+    t[SPECIAL + 0x2A] = { "slt", InterpretSlt, EmitSlt, R_TYPE };
+    t[SPECIAL + 0x2B] = { "sltu", InterpretSltu, EmitSltu, R_TYPE };
+}
+
+constexpr void MakeRegimm(std::array<InstructionInfo, DECODE_TABLE_SIZE>& t) {
+    // The R3000A only looks at bit 0 (greater or equal) and bits 4-1 (link) of rt
+    for (uint32_t rt = 0u; rt < 32u; ++rt) {
+        const bool link = (rt & 0x1Eu) == 0x10u;
+        if (rt & 1u) {
+            t[REGIMM + rt] = link
+                ? InstructionInfo { "bgezal", InterpretBgezal, nullptr, READS_RS | IS_BRANCH | WRITES_RA }
+                : InstructionInfo { "bgez", InterpretBgez, nullptr, READS_RS | IS_BRANCH };
+        } else {
+            t[REGIMM + rt] = link
+                ? InstructionInfo { "bltzal", InterpretBltzal, nullptr, READS_RS | IS_BRANCH | WRITES_RA }
+                : InstructionInfo { "bltz", InterpretBltz, nullptr, READS_RS | IS_BRANCH };
+        }
+    }
+}
+
+constexpr void MakeCoprocessors(std::array<InstructionInfo, DECODE_TABLE_SIZE>& t) {
+    // Coprocessor moves to general purpose registers have a load delay
+    t[COP0 + 0x00] = { "mfc0", InterpretMfc0, nullptr, WRITES_RT | IS_LOAD };
+    t[COP0 + 0x04] = { "mtc0", InterpretMtc0, nullptr, READS_RT };
+    // Commands are told apart by function, of which only RFE exists
+    for (uint32_t rs = 0x10u; rs < 0x20u; ++rs) {
+        t[COP0 + rs] = { "cop0", InterpretCop0Command, nullptr, CAN_FAULT };
+    }
+    t[COP2 + 0x00] = { "mfc2", InterpretMfc2, nullptr, WRITES_RT | IS_LOAD };
+    t[COP2 + 0x02] = { "cfc2", InterpretCfc2, nullptr, WRITES_RT | IS_LOAD };
+    t[COP2 + 0x04] = { "mtc2", InterpretMtc2, nullptr, READS_RT };
+    t[COP2 + 0x06] = { "ctc2", InterpretCtc2, nullptr, READS_RT };
+    // GTE commands are called directly from compiled code
+    for (uint32_t rs = 0x10u; rs < 0x20u; ++rs) {
+        t[COP2 + rs] = { "cop2", InterpretCop2Command, EmitCop2Command, 0u };
+    }
+}
+
+constexpr std::array<InstructionInfo, DECODE_TABLE_SIZE> MakeTable() {
+    std::array<InstructionInfo, DECODE_TABLE_SIZE> table { };
+    for (auto& entry : table) {
+        entry = Reserved();
+    }
+    MakePrimary(table);
+    MakeSpecial(table);
+    MakeRegimm(table);
+    MakeCoprocessors(table);
+    return table;
+}
+
+constexpr std::array<InstructionInfo, DECODE_TABLE_SIZE> TABLE = MakeTable();
+
+}
+
+uint32_t DecodeIndex(uint32_t opcode) {
+    const uint32_t selector = SELECTORS[InstructionOp(opcode)];
+    const uint32_t shift = (selector >> 16u) & 0xFFu;
+    const uint32_t mask = selector >> 24u;
+    return (selector & 0xFFFFu) + ((opcode >> shift) & mask);
+}
+
+const InstructionInfo& DecodeInstruction(uint32_t opcode) {
+    return TABLE[DecodeIndex(opcode)];
+}
+
+const InstructionInfo& InstructionAt(uint32_t index) {
+    return TABLE[index];
+}
+
+std::string DisassembleInstruction(uint32_t pc, uint32_t opcode) {
+    const InstructionInfo& info = DecodeInstruction(opcode);
+    const uint32_t op = InstructionOp(opcode);
+    const uint32_t function = InstructionFunction(opcode);
+    const uint32_t rs = InstructionRs(opcode);
+    const uint32_t rt = InstructionRt(opcode);
+    const uint32_t rd = InstructionRd(opcode);
+    const int32_t offset = static_cast<int32_t>(InstructionImmediateExtended(opcode));
+    const uint32_t branchTarget = pc + 4u + (InstructionImmediateExtended(opcode) << 2u);
+    char text[64];
+    if (opcode == 0u) {
+        std::snprintf(text, sizeof(text), "nop");
+    } else if (op == 0x02u || op == 0x03u) {
+        std::snprintf(text, sizeof(text), "%s 0x%08x", info.mnemonic,
+                      ((pc + 4u) & 0xF0000000u) | (InstructionTarget(opcode) << 2u));
+    } else if (op == 0x00u && function == 0x08u) {
+        std::snprintf(text, sizeof(text), "%s $%u", info.mnemonic, rs);
+    } else if (op == 0x00u && function == 0x09u) {
+        std::snprintf(text, sizeof(text), "%s $%u, $%u", info.mnemonic, rd, rs);
+    } else if (op == 0x04u || op == 0x05u) {
+        std::snprintf(text, sizeof(text), "%s $%u, $%u, 0x%08x", info.mnemonic, rs, rt, branchTarget);
+    } else if (info.flags & IS_BRANCH) {
+        std::snprintf(text, sizeof(text), "%s $%u, 0x%08x", info.mnemonic, rs, branchTarget);
+    } else if (op >= 0x20u && (info.flags & READS_RS)) {
+        std::snprintf(text, sizeof(text), "%s $%u, %d($%u)", info.mnemonic, rt, offset, rs);
+    } else if (op == 0x0Fu) {
+        std::snprintf(text, sizeof(text), "%s $%u, 0x%04x", info.mnemonic, rt, InstructionImmediate(opcode));
+    } else if (op >= 0x0Cu && op <= 0x0Eu) {
+        std::snprintf(text, sizeof(text), "%s $%u, $%u, 0x%04x", info.mnemonic, rt, rs, InstructionImmediate(opcode));
+    } else if (op >= 0x08u && op <= 0x0Bu) {
+        std::snprintf(text, sizeof(text), "%s $%u, $%u, %d", info.mnemonic, rt, rs, offset);
+    } else if (op == 0x10u || op == 0x12u) {
+        // Coprocessor moves name the coprocessor register with rd, commands are the whole opcode
+        if (rs < 0x10u) {
+            std::snprintf(text, sizeof(text), "%s $%u, $%u", info.mnemonic, rt, rd);
+        } else if (op == 0x12u) {
+            std::snprintf(text, sizeof(text), "%s 0x%07x", info.mnemonic, opcode & 0x01FFFFFFu);
+        } else {
+            std::snprintf(text, sizeof(text), "%s", function == 0x10u ? "rfe" : "reserved");
+        }
+    } else if (op != 0x00u) {
+        std::snprintf(text, sizeof(text), "%s", info.mnemonic);
+    } else if (function <= 0x03u) {
+        std::snprintf(text, sizeof(text), "%s $%u, $%u, %u", info.mnemonic, rd, rt, InstructionShift(opcode));
+    } else if (function <= 0x07u) {
+        std::snprintf(text, sizeof(text), "%s $%u, $%u, $%u", info.mnemonic, rd, rt, rs);
+    } else if (function == 0x10u || function == 0x12u) {
+        std::snprintf(text, sizeof(text), "%s $%u", info.mnemonic, rd);
+    } else if (function == 0x11u || function == 0x13u) {
+        std::snprintf(text, sizeof(text), "%s $%u", info.mnemonic, rs);
+    } else if (function >= 0x18u && function <= 0x1Bu) {
+        std::snprintf(text, sizeof(text), "%s $%u, $%u", info.mnemonic, rs, rt);
+    } else if (function >= 0x20u && (info.flags & WRITES_RD)) {
+        std::snprintf(text, sizeof(text), "%s $%u, $%u, $%u", info.mnemonic, rd, rs, rt);
+    } else {
+        std::snprintf(text, sizeof(text), "%s", info.mnemonic);
+    }
+    return text;
+}
+
+}
@@ -5,6 +5,17 @@ namespace rbrown {
 
 namespace {
 
+constexpr uint32_t RSP_BASE = 4u;
+// With mod 0 this rm is a disp32 relative to the next instruction
+constexpr uint32_t RIP_RELATIVE = 5u;
+
+constexpr size_t LITERAL_ALIGNMENT = 8u;
+
+bool InRel32Range(uintptr_t target, uintptr_t next) {
+    const auto displacement = static_cast<int64_t>(target - next);
+    return displacement == static_cast<int32_t>(displacement);
+}
+
 uint8_t Rex(uint32_t w, uint32_t r, uint32_t x, uint32_t b) {
     return static_cast<uint8_t>(0x40u + ((w & 1u) << 3u) + ((r & 1u) << 2u) + ((x & 1u) << 1u) + (b & 1u));
 }
@@ -15,7 +26,15 @@ uint8_t ModRM(uint32_t mod, uint32_t reg, uint32_t rm) {
 
 }
 
-EmitterX64::EmitterX64(CodeBuffer& buf) : buffer{ buf }, callSites{ }, nextLabelId {0}  {}
+EmitterX64::EmitterX64(CodeBuffer& buf) : buffer{ buf }, callSites{ }, literalSites{ }, nextLabelId {0}, fixUpCount { 0 }, callCount { 0 }, returns { } {}
+
+uint64_t EmitterX64::LabelCount() const { return nextLabelId; }
+
+uint64_t EmitterX64::FixUpCount() const { return fixUpCount; }
+
+uint64_t EmitterX64::CallCount() const { return callCount; }
+
+const std::vector<size_t>& EmitterX64::Returns() const { return returns; }
 
 Label EmitterX64::NewLabel() {
     return static_cast<Label>(nextLabelId++);
@@ -34,7 +53,12 @@ void EmitterX64::Bind(Label& label) {
 }
 
 void EmitterX64::FixUpCallSite(const CallSite& site, const Label& label) {
-    buffer.Byte(site.Position() - 1u, static_cast<uint8_t>(label.Position() - site.Position()));
+    ++fixUpCount;
+    if (site.Wide()) {
+        buffer.DWord(site.Position() - 4u, static_cast<uint32_t>(label.Position() - site.Position()));
+    } else {
+        buffer.Byte(site.Position() - 1u, static_cast<uint8_t>(label.Position() - site.Position()));
+    }
 }
 
 void EmitterX64::Jno(const Label& label) {
@@ -47,6 +71,16 @@ void EmitterX64::Jno(const Label& label) {
     }
 }
 
+void EmitterX64::Je(const Label& label) {
+    buffer.Bytes({ 0x74u, 0x00u });
+    const size_t position = buffer.Position();
+    if (label.Bound()) {
+        FixUpCallSite(static_cast<CallSite>(position), label);
+    } else {
+        callSites[label.Id()].emplace_back(position);
+    }
+}
+
 void EmitterX64::Jne(const Label& label) {
     buffer.Bytes({ 0x75u, 0x00u });
     const size_t position = buffer.Position();
@@ -67,6 +101,46 @@ void EmitterX64::Js(const Label& label) {
     }
 }
 
+void EmitterX64::Jl(const Label& label) {
+    buffer.Bytes({ 0x7Cu, 0x00u });
+    const size_t position = buffer.Position();
+    if (label.Bound()) {
+        FixUpCallSite(static_cast<CallSite>(position), label);
+    } else {
+        callSites[label.Id()].emplace_back(position);
+    }
+}
+
+void EmitterX64::Jge(const Label& label) {
+    buffer.Bytes({ 0x7Du, 0x00u });
+    const size_t position = buffer.Position();
+    if (label.Bound()) {
+        FixUpCallSite(static_cast<CallSite>(position), label);
+    } else {
+        callSites[label.Id()].emplace_back(position);
+    }
+}
+
+void EmitterX64::Jle(const Label& label) {
+    buffer.Bytes({ 0x7Eu, 0x00u });
+    const size_t position = buffer.Position();
+    if (label.Bound()) {
+        FixUpCallSite(static_cast<CallSite>(position), label);
+    } else {
+        callSites[label.Id()].emplace_back(position);
+    }
+}
+
+void EmitterX64::Jg(const Label& label) {
+    buffer.Bytes({ 0x7Fu, 0x00u });
+    const size_t position = buffer.Position();
+    if (label.Bound()) {
+        FixUpCallSite(static_cast<CallSite>(position), label);
+    } else {
+        callSites[label.Id()].emplace_back(position);
+    }
+}
+
 void EmitterX64::Jmp(const Label& label) {
     buffer.Bytes({ 0xEBu, 0x00u });
     const size_t position = buffer.Position();
@@ -77,6 +151,17 @@ void EmitterX64::Jmp(const Label& label) {
     }
 }
 
+void EmitterX64::Jmp32(const Label& label) {
+    buffer.Byte(0xE9u);
+    buffer.DWord(0u);
+    const CallSite site(buffer.Position(), true);
+    if (label.Bound()) {
+        FixUpCallSite(site, label);
+    } else {
+        callSites[label.Id()].push_back(site);
+    }
+}
+
 void EmitterX64::TestALImm8(uint8_t imm8) {
     buffer.Bytes({ 0xA8u, imm8 });
 }
@@ -87,6 +172,27 @@ void EmitterX64::CmpR32Imm8(uint32_t rm, uint8_t imm8) {
     buffer.Bytes({rex, 0x83u, mod, imm8});
 }
 
+void EmitterX64::CmpR32R32(uint32_t rm, uint32_t reg) {
+    const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, reg, rm);
+    buffer.Bytes({ rex, 0x39u, mod });
+}
+
+void EmitterX64::CmpR32Imm32(uint32_t rm, uint32_t imm32) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 7u, rm);
+    buffer.Bytes({ rex, 0x81u, mod });
+    buffer.DWord(imm32);
+}
+
+void EmitterX64::CmpDisp32Imm8(uint32_t rm, uint32_t disp32, uint8_t imm8) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(2u, 7u, rm);
+    buffer.Bytes({ rex, 0x83u, mod });
+    buffer.DWord(disp32);
+    buffer.Byte(imm8);
+}
+
 void EmitterX64::AddR32R32(uint32_t rm, uint32_t reg) {
     const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
     const uint8_t mod = ModRM(3u, reg, rm);
@@ -106,18 +212,188 @@ void EmitterX64::AddR64Imm8(uint32_t rm, uint8_t imm8) {
     buffer.Bytes({ rex, 0x83u, mod, imm8 });
 }
 
+void EmitterX64::AddDisp8R64(uint32_t rm, uint8_t disp8, uint32_t reg) {
+    const uint8_t rex = Rex(1u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(1u, reg, rm);
+    buffer.Bytes({ rex, 0x01u, mod, disp8 });
+}
+
+void EmitterX64::IncQwordDisp8(uint32_t rm, uint8_t disp8) {
+    const uint8_t rex = Rex(1u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(1u, 0u, rm);
+    buffer.Bytes({ rex, 0xFFu, mod, disp8 });
+}
+
 void EmitterX64::SubR32R32(uint32_t rm, uint32_t reg) {
     const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
     const uint8_t mod = ModRM(3u, reg, rm);
     buffer.Bytes({ rex, 0x29u, mod });
 }
 
+void EmitterX64::SubR64R64(uint32_t rm, uint32_t reg) {
+    const uint8_t rex = Rex(1u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, reg, rm);
+    buffer.Bytes({ rex, 0x29u, mod });
+}
+
 void EmitterX64::SubR64Imm8(uint32_t rm, uint8_t imm8) {
     const uint8_t rex = Rex(1u, 0u, 0u, rm >> 3u);
     const uint8_t mod = ModRM(3u, 5u, rm);
     buffer.Bytes({ rex, 0x83u, mod, imm8 });
 }
 
+void EmitterX64::SubDisp32Imm32(uint32_t rm, uint32_t disp32, uint32_t imm32) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(2u, 5u, rm);
+    buffer.Bytes({ rex, 0x81u, mod });
+    buffer.DWord(disp32);
+    buffer.DWord(imm32);
+}
+
+void EmitterX64::AndR32R32(uint32_t rm, uint32_t reg) {
+    const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, reg, rm);
+    buffer.Bytes({ rex, 0x21u, mod });
+}
+
+void EmitterX64::AndR32Imm32(uint32_t rm, uint32_t imm32) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 4u, rm);
+    buffer.Bytes({ rex, 0x81u, mod });
+    buffer.DWord(imm32);
+}
+
+void EmitterX64::OrR32R32(uint32_t rm, uint32_t reg) {
+    const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, reg, rm);
+    buffer.Bytes({ rex, 0x09u, mod });
+}
+
+void EmitterX64::OrR64R64(uint32_t rm, uint32_t reg) {
+    const uint8_t rex = Rex(1u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, reg, rm);
+    buffer.Bytes({ rex, 0x09u, mod });
+}
+
+void EmitterX64::OrR32Imm32(uint32_t rm, uint32_t imm32) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 1u, rm);
+    buffer.Bytes({ rex, 0x81u, mod });
+    buffer.DWord(imm32);
+}
+
+void EmitterX64::XorR32R32(uint32_t rm, uint32_t reg) {
+    const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, reg, rm);
+    buffer.Bytes({ rex, 0x31u, mod });
+}
+
+void EmitterX64::XorR32Imm32(uint32_t rm, uint32_t imm32) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 6u, rm);
+    buffer.Bytes({ rex, 0x81u, mod });
+    buffer.DWord(imm32);
+}
+
+void EmitterX64::NotR32(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 2u, rm);
+    buffer.Bytes({ rex, 0xF7u, mod });
+}
+
+void EmitterX64::MulR32(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 4u, rm);
+    buffer.Bytes({ rex, 0xF7u, mod });
+}
+
+void EmitterX64::ImulR32(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 5u, rm);
+    buffer.Bytes({ rex, 0xF7u, mod });
+}
+
+void EmitterX64::DivR32(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 6u, rm);
+    buffer.Bytes({ rex, 0xF7u, mod });
+}
+
+void EmitterX64::IdivR32(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 7u, rm);
+    buffer.Bytes({ rex, 0xF7u, mod });
+}
+
+void EmitterX64::Cdq() {
+    const uint8_t rex = Rex(0u, 0u, 0u, 0u);
+    buffer.Bytes({ rex, 0x99u });
+}
+
+void EmitterX64::Rdtsc() {
+    buffer.Bytes({ 0x0Fu, 0x31u });
+}
+
+void EmitterX64::ShlR32Imm8(uint32_t rm, uint8_t imm8) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 4u, rm);
+    buffer.Bytes({ rex, 0xC1u, mod, imm8 });
+}
+
+void EmitterX64::ShlR64Imm8(uint32_t rm, uint8_t imm8) {
+    const uint8_t rex = Rex(1u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 4u, rm);
+    buffer.Bytes({ rex, 0xC1u, mod, imm8 });
+}
+
+void EmitterX64::ShrR32Imm8(uint32_t rm, uint8_t imm8) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 5u, rm);
+    buffer.Bytes({ rex, 0xC1u, mod, imm8 });
+}
+
+void EmitterX64::SarR32Imm8(uint32_t rm, uint8_t imm8) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 7u, rm);
+    buffer.Bytes({ rex, 0xC1u, mod, imm8 });
+}
+
+void EmitterX64::ShlR32CL(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 4u, rm);
+    buffer.Bytes({ rex, 0xD3u, mod });
+}
+
+void EmitterX64::ShrR32CL(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 5u, rm);
+    buffer.Bytes({ rex, 0xD3u, mod });
+}
+
+void EmitterX64::SarR32CL(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 7u, rm);
+    buffer.Bytes({ rex, 0xD3u, mod });
+}
+
+void EmitterX64::SetlR8(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 0u, rm);
+    buffer.Bytes({ rex, 0x0Fu, 0x9Cu, mod });
+}
+
+void EmitterX64::SetbR8(uint32_t rm) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, 0u, rm);
+    buffer.Bytes({ rex, 0x0Fu, 0x92u, mod });
+}
+
+void EmitterX64::MovzxR32R8(uint32_t reg, uint32_t rm) {
+    const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(3u, reg, rm);
+    buffer.Bytes({ rex, 0x0Fu, 0xB6u, mod });
+}
+
 void EmitterX64::MovR32R32(uint32_t rm, uint32_t reg) {
     const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
     const uint8_t mod = ModRM(3u, reg, rm);
@@ -136,6 +412,28 @@ void EmitterX64::MovDisp8R32(uint32_t rm, uint8_t disp8, uint32_t reg) {
     buffer.Bytes({ rex, 0x89u, mod, disp8 });
 }
 
+void EmitterX64::MovR32Disp32(uint32_t reg, uint32_t rm, uint32_t disp32) {
+    const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(2u, reg, rm);
+    buffer.Bytes({ rex, 0x8Bu, mod });
+    buffer.DWord(disp32);
+}
+
+void EmitterX64::MovDisp32R32(uint32_t rm, uint32_t disp32, uint32_t reg) {
+    const uint8_t rex = Rex(0u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(2u, reg, rm);
+    buffer.Bytes({ rex, 0x89u, mod });
+    buffer.DWord(disp32);
+}
+
+void EmitterX64::MovDisp32Imm32(uint32_t rm, uint32_t disp32, uint32_t imm32) {
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(2u, 0u, rm);
+    buffer.Bytes({ rex, 0xC7u, mod });
+    buffer.DWord(disp32);
+    buffer.DWord(imm32);
+}
+
 void EmitterX64::MovR32Imm32(uint32_t rw, uint32_t imm32) {
     const uint8_t rex = Rex(0u, 0u, 0u, rw >> 3u);
     const uint8_t code = static_cast<const uint8_t>(0xB8u + (rw & 7u));
@@ -156,6 +454,32 @@ void EmitterX64::MovR64Imm64(uint32_t rw, uint64_t imm64) {
     buffer.QWord(imm64);
 }
 
+void EmitterX64::MovR64Literal(uint32_t reg, uint64_t value) {
+    const uint8_t rex = Rex(1u, reg >> 3u, 0u, 0u);
+    const uint8_t mod = ModRM(0u, reg, RIP_RELATIVE);
+    buffer.Bytes({ rex, 0x8Bu, mod });
+    buffer.DWord(0u);
+    literalSites[value].push_back(buffer.Position());
+}
+
+void EmitterX64::EmitLiteralPool() {
+    // Each distinct value is written once and every load of it pointed there
+    if (literalSites.empty()) {
+        return;
+    }
+    while (buffer.Position() % LITERAL_ALIGNMENT) {
+        buffer.Byte(0xCCu);
+    }
+    for (const auto& [value, sites] : literalSites) {
+        const size_t position = buffer.Position();
+        buffer.QWord(value);
+        for (const size_t site : sites) {
+            buffer.DWord(site - 4u, static_cast<uint32_t>(position - site));
+        }
+    }
+    literalSites.clear();
+}
+
 void EmitterX64::MovEAXAbs(uintptr_t address) {
     buffer.Byte(0xA1u);
     buffer.QWord(address);
@@ -172,6 +496,13 @@ void EmitterX64::LeaR64Disp8(uint32_t reg, uint32_t rm, uint8_t disp8) {
     buffer.Bytes({rex, 0x8D, mod, disp8});
 }
 
+void EmitterX64::LeaR64Disp32(uint32_t reg, uint32_t rm, uint32_t disp32) {
+    const uint8_t rex = Rex(1u, reg >> 3u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(2u, reg, rm);
+    buffer.Bytes({ rex, 0x8Du, mod });
+    buffer.DWord(disp32);
+}
+
 void EmitterX64::PushR64(uint32_t rd) {
     const uint8_t rex = Rex(0u, 0u, 0u, rd >> 3u);
     const uint8_t code = static_cast<const uint8_t>(0x50u + (rd & 7u));
@@ -184,16 +515,91 @@ void EmitterX64::PopR64(uint32_t rd) {
     buffer.Bytes({ rex, code });
 }
 
+void EmitterX64::JmpRel32(uint32_t rel32) {
+    buffer.Byte(0xE9u);
+    buffer.DWord(rel32);
+}
+
+void EmitterX64::Jmp(uintptr_t target) {
+    // Far targets go the same way as they do for Call
+    const uintptr_t next = buffer.BufferAddress() + buffer.Position() + 5u;
+    if (InRel32Range(target, next)) {
+        JmpRel32(static_cast<uint32_t>(target - next));
+        return;
+    }
+    const uintptr_t veneer = buffer.Veneer(target);
+    if (veneer && InRel32Range(veneer, next)) {
+        JmpRel32(static_cast<uint32_t>(veneer - next));
+    } else {
+        JmpLiteral(target);
+    }
+}
+
+void EmitterX64::JmpLiteral(uintptr_t target) {
+    const uint8_t rex = Rex(0u, 0u, 0u, 0u);
+    const uint8_t mod = ModRM(0u, 4u, RIP_RELATIVE);
+    buffer.Bytes({ rex, 0xFFu, mod });
+    buffer.DWord(0u);
+    literalSites[target].push_back(buffer.Position());
+}
+
 void EmitterX64::CallRel32(uint32_t rel32) {
+    ++callCount;
     buffer.Byte(0xE8u);
     buffer.DWord(rel32);
 }
 
 void EmitterX64::Call(uintptr_t target) {
-    CallRel32(static_cast<uint32_t>(target - (buffer.BufferAddress() + buffer.Position() + 5u)));
+    // Targets more than 2 GiB away are called through the buffer's veneer for them
+    // and if the veneer island is full through the literal pool
+    const uintptr_t next = buffer.BufferAddress() + buffer.Position() + 5u;
+    if (InRel32Range(target, next)) {
+        CallRel32(static_cast<uint32_t>(target - next));
+        return;
+    }
+    const uintptr_t veneer = buffer.Veneer(target);
+    if (veneer && InRel32Range(veneer, next)) {
+        CallRel32(static_cast<uint32_t>(veneer - next));
+    } else {
+        CallLiteral(target);
+    }
+}
+
+void EmitterX64::CallLiteral(uintptr_t target) {
+    ++callCount;
+    const uint8_t rex = Rex(0u, 0u, 0u, 0u);
+    const uint8_t mod = ModRM(0u, 2u, RIP_RELATIVE);
+    buffer.Bytes({ rex, 0xFFu, mod });
+    buffer.DWord(0u);
+    literalSites[target].push_back(buffer.Position());
+}
+
+void EmitterX64::CallDisp8(uint32_t rm, uint8_t disp8) {
+    ++callCount;
+    // RSP and R12 as a base require a SIB byte
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(1u, 2u, rm);
+    if ((rm & 7u) == RSP_BASE) {
+        buffer.Bytes({ rex, 0xFFu, mod, 0x24u, disp8 });
+    } else {
+        buffer.Bytes({ rex, 0xFFu, mod, disp8 });
+    }
+}
+
+void EmitterX64::CallDisp32(uint32_t rm, uint32_t disp32) {
+    ++callCount;
+    const uint8_t rex = Rex(0u, 0u, 0u, rm >> 3u);
+    const uint8_t mod = ModRM(2u, 2u, rm);
+    if ((rm & 7u) == RSP_BASE) {
+        buffer.Bytes({ rex, 0xFFu, mod, 0x24u });
+    } else {
+        buffer.Bytes({ rex, 0xFFu, mod });
+    }
+    buffer.DWord(disp32);
 }
 
 void EmitterX64::Ret() {
+    returns.push_back(buffer.Position());
     buffer.Byte(0xC3u);
 }
 
@@ -0,0 +1,816 @@
+#include "GTE.h"
+
+#include <algorithm>
+#include <array>
+#include <immintrin.h>
+
+namespace rbrown {
+
+namespace {
+
+// Data registers
+constexpr uint32_t RGBC = 6u;
+constexpr uint32_t OTZ = 7u;
+constexpr uint32_t IR0 = 8u;
+constexpr uint32_t SXY0 = 12u;
+constexpr uint32_t SXYP = 15u;
+constexpr uint32_t SZ0 = 16u;
+constexpr uint32_t RGB0 = 20u;
+constexpr uint32_t MAC0 = 24u;
+constexpr uint32_t IRGB = 28u;
+constexpr uint32_t ORGB = 29u;
+constexpr uint32_t LZCS = 30u;
+constexpr uint32_t LZCR = 31u;
+
+// Control registers, each matrix is followed three registers later by its translation
+constexpr uint32_t RT = 0u;
+constexpr uint32_t TR = 5u;
+constexpr uint32_t LLM = 8u;
+constexpr uint32_t BK = 13u;
+constexpr uint32_t LCM = 16u;
+constexpr uint32_t FC = 21u;
+constexpr uint32_t OFX = 24u;
+constexpr uint32_t OFY = 25u;
+constexpr uint32_t H = 26u;
+constexpr uint32_t DQA = 27u;
+constexpr uint32_t DQB = 28u;
+constexpr uint32_t ZSF3 = 29u;
+constexpr uint32_t ZSF4 = 30u;
+constexpr uint32_t FLAG = 31u;
+
+// FLAG bits, the per component bits are shifted right by the component number
+constexpr uint32_t FLAG_MAC_POSITIVE = 0x80000000u;
+constexpr uint32_t FLAG_MAC_NEGATIVE = 0x10000000u;
+constexpr uint32_t FLAG_IR_SATURATED = 0x02000000u;
+constexpr uint32_t FLAG_COLOR_SATURATED = 0x00400000u;
+constexpr uint32_t FLAG_SZ_SATURATED = 1u << 18u;
+constexpr uint32_t FLAG_DIVIDE_OVERFLOW = 1u << 17u;
+constexpr uint32_t FLAG_MAC0_POSITIVE = 1u << 16u;
+constexpr uint32_t FLAG_MAC0_NEGATIVE = 1u << 15u;
+constexpr uint32_t FLAG_SX_SATURATED = 1u << 14u;
+constexpr uint32_t FLAG_SY_SATURATED = 1u << 13u;
+constexpr uint32_t FLAG_IR0_SATURATED = 1u << 12u;
+constexpr uint32_t FLAG_ERROR = 1u << 31u;
+constexpr uint32_t FLAG_ERROR_MASK = 0x7F87E000u;
+constexpr uint32_t FLAG_WRITABLE = 0x7FFFF000u;
+
+// MAC1-3 accumulate in 44 bits
+constexpr int64_t MAC_MIN = -(int64_t { 1 } << 43u);
+constexpr int64_t MAC_MAX = (int64_t { 1 } << 43u) - 1;
+
+uint32_t SignExtend16(uint32_t value) {
+    return static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(value)));
+}
+
+uint32_t Shift(uint32_t opcode) { return ((opcode >> 19u) & 1u) * 12u; }
+
+bool Lm(uint32_t opcode) { return (opcode >> 10u) & 1u; }
+
+int64_t Wrap44(int64_t value) {
+    return static_cast<int64_t>(static_cast<uint64_t>(value) << 20u) >> 20u;
+}
+
+uint32_t MacFlags(uint32_t i, int64_t value) {
+    if (value > MAC_MAX) {
+        return FLAG_MAC_POSITIVE >> i;
+    }
+    if (value < MAC_MIN) {
+        return FLAG_MAC_NEGATIVE >> i;
+    }
+    return 0u;
+}
+
+uint32_t Mac0Flags(int64_t value) {
+    if (value > INT32_MAX) {
+        return FLAG_MAC0_POSITIVE;
+    }
+    if (value < INT32_MIN) {
+        return FLAG_MAC0_NEGATIVE;
+    }
+    return 0u;
+}
+
+uint32_t LeadingSignBits(uint32_t value) {
+    const uint32_t bits = (value & 0x80000000u) ? ~value : value;
+    return bits ? static_cast<uint32_t>(__builtin_clz(bits)) : 32u;
+}
+
+constexpr std::array<uint8_t, 257> MakeUnrTable() {
+    std::array<uint8_t, 257> table { };
+    for (int32_t i = 0; i < 257; ++i) {
+        table[i] = static_cast<uint8_t>(std::max(0, (0x40000 / (i + 0x100) + 1) / 2 - 0x101));
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 257> UNR_TABLE = MakeUnrTable();
+
+uint32_t UnrDivide(uint32_t h, uint32_t sz3) {
+    // The hardware divides with a reciprocal table and two Newton-Raphson steps
+    // and results must match it bit for bit
+    const uint32_t z = static_cast<uint32_t>(__builtin_clz(sz3)) - 16u;
+    const uint64_t n = static_cast<uint64_t>(h) << z;
+    uint32_t d = sz3 << z;
+    const uint32_t u = UNR_TABLE[(d - 0x7FC0u) >> 7u] + 0x101u;
+    d = (0x2000080u - d * u) >> 8u;
+    d = (0x0000080u + d * u) >> 8u;
+    return static_cast<uint32_t>(std::min<uint64_t>(0x1FFFFu, (n * d + 0x8000u) >> 16u));
+}
+
+// A 3x3 matrix times a vector plus a translation with every partial
+// sum checked against 44 bits, the kernels return the FLAG bits raised
+struct TransformInput {
+    alignas(32) int64_t translation[4];
+    alignas(32) int64_t columns[3][4];
+    int64_t vector[3];
+};
+
+struct Kernels {
+    uint32_t (*transform)(int64_t*, const TransformInput&);
+    const char* name;
+};
+
+uint32_t WrapLanes(int64_t* lanes) {
+    uint32_t flags = 0u;
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        flags |= MacFlags(i + 1u, lanes[i]);
+        lanes[i] = Wrap44(lanes[i]);
+    }
+    return flags;
+}
+
+uint32_t ScalarTransform(int64_t* out, const TransformInput& in) {
+    uint32_t flags = 0u;
+    std::copy(in.translation, in.translation + 3, out);
+    for (uint32_t j = 0u; j < 3u; ++j) {
+        for (uint32_t i = 0u; i < 3u; ++i) {
+            out[i] += in.columns[j][i] * in.vector[j];
+        }
+        flags |= WrapLanes(out);
+    }
+    return flags;
+}
+
+__attribute__((target("sse4.1")))
+uint32_t Sse41Transform(int64_t* out, const TransformInput& in) {
+    // Rows 0-1 in one register and row 2 in another, pmuldq gives 64 bit products
+    const __m128i bias = _mm_set1_epi64x(-MAC_MIN);
+    const __m128i range = _mm_set1_epi64x(~((int64_t { 1 } << 44u) - 1));
+    alignas(16) int64_t lanes[4];
+    __m128i low = _mm_load_si128(reinterpret_cast<const __m128i*>(in.translation));
+    __m128i high = _mm_load_si128(reinterpret_cast<const __m128i*>(in.translation + 2));
+    uint32_t flags = 0u;
+    for (uint32_t j = 0u; j < 3u; ++j) {
+        const __m128i v = _mm_set1_epi64x(in.vector[j]);
+        low = _mm_add_epi64(low, _mm_mul_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(in.columns[j])), v));
+        high = _mm_add_epi64(high, _mm_mul_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(in.columns[j] + 2)), v));
+        // Sums outside 44 bits are rare so they are flagged and wrapped one lane at a time
+        if (!_mm_testz_si128(_mm_add_epi64(low, bias), range) || !_mm_testz_si128(_mm_add_epi64(high, bias), range)) {
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), low);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 2), high);
+            flags |= WrapLanes(lanes);
+            low = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes));
+            high = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes + 2));
+        }
+    }
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), low);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 2), high);
+    std::copy(lanes, lanes + 3, out);
+    return flags;
+}
+
+__attribute__((target("avx2")))
+uint32_t Avx2Transform(int64_t* out, const TransformInput& in) {
+    // All three rows in one register, the fourth lane is always zero
+    const __m256i bias = _mm256_set1_epi64x(-MAC_MIN);
+    const __m256i range = _mm256_set1_epi64x(~((int64_t { 1 } << 44u) - 1));
+    alignas(32) int64_t lanes[4];
+    __m256i acc = _mm256_load_si256(reinterpret_cast<const __m256i*>(in.translation));
+    uint32_t flags = 0u;
+    for (uint32_t j = 0u; j < 3u; ++j) {
+        const __m256i column = _mm256_load_si256(reinterpret_cast<const __m256i*>(in.columns[j]));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(column, _mm256_set1_epi64x(in.vector[j])));
+        if (!_mm256_testz_si256(_mm256_add_epi64(acc, bias), range)) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+            flags |= WrapLanes(lanes);
+            acc = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes));
+        }
+    }
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    std::copy(lanes, lanes + 3, out);
+    return flags;
+}
+
+Kernels SelectKernels() {
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernels { Avx2Transform, "AVX2" };
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Kernels { Sse41Transform, "SSE4.1" };
+    }
+    return Kernels { ScalarTransform, "Scalar" };
+}
+
+const Kernels& SelectedKernels() {
+    static const Kernels kernels = SelectKernels();
+    return kernels;
+}
+
+template<void (GTE::*Command)(uint32_t)>
+void Execute(GTE* gte, uint32_t opcode) {
+    (gte->*Command)(opcode);
+}
+
+constexpr std::array<GteCommand, GTE_COMMAND_COUNT> MakeCommands() {
+    std::array<GteCommand, GTE_COMMAND_COUNT> commands { };
+    for (auto& command : commands) {
+        command = Execute<&GTE::Reserved>;
+    }
+    commands[0x01] = Execute<&GTE::Rtps>;
+    commands[0x06] = Execute<&GTE::Nclip>;
+    commands[0x0C] = Execute<&GTE::Op>;
+    commands[0x10] = Execute<&GTE::Dpcs>;
+    commands[0x11] = Execute<&GTE::Intpl>;
+    commands[0x12] = Execute<&GTE::Mvmva>;
+    commands[0x13] = Execute<&GTE::Ncds>;
+    commands[0x14] = Execute<&GTE::Cdp>;
+    commands[0x16] = Execute<&GTE::Ncdt>;
+    commands[0x1B] = Execute<&GTE::Nccs>;
+    commands[0x1C] = Execute<&GTE::Cc>;
+    commands[0x1E] = Execute<&GTE::Ncs>;
+    commands[0x20] = Execute<&GTE::Nct>;
+    commands[0x28] = Execute<&GTE::Sqr>;
+    commands[0x29] = Execute<&GTE::Dcpl>;
+    commands[0x2A] = Execute<&GTE::Dpct>;
+    commands[0x2D] = Execute<&GTE::Avsz3>;
+    commands[0x2E] = Execute<&GTE::Avsz4>;
+    commands[0x30] = Execute<&GTE::Rtpt>;
+    commands[0x3D] = Execute<&GTE::Gpf>;
+    commands[0x3E] = Execute<&GTE::Gpl>;
+    commands[0x3F] = Execute<&GTE::Ncct>;
+    return commands;
+}
+
+constexpr std::array<GteCommand, GTE_COMMAND_COUNT> COMMANDS = MakeCommands();
+
+}
+
+GTE::GTE() : data { 0 }, control { 0 } {}
+
+uint32_t GTE::ReadRegister(uint32_t r) const {
+    switch (r) {
+        case SXYP:
+            return data[SXY0 + 2u];
+        case IRGB:
+        case ORGB: {
+            uint32_t value = 0u;
+            for (uint32_t i = 0u; i < 3u; ++i) {
+                value |= static_cast<uint32_t>(std::clamp(Ir(i + 1u) >> 7, 0, 0x1F)) << (5u * i);
+            }
+            return value;
+        }
+        default:
+            return data[r];
+    }
+}
+
+void GTE::WriteRegister(uint32_t r, uint32_t value) {
+    switch (r) {
+        case 1u: case 3u: case 5u:
+        case 8u: case 9u: case 10u: case 11u:
+            data[r] = SignExtend16(value);
+            break;
+        case OTZ:
+        case 16u: case 17u: case 18u: case 19u:
+            data[r] = value & 0xFFFFu;
+            break;
+        case SXYP:
+            data[SXY0] = data[SXY0 + 1u];
+            data[SXY0 + 1u] = data[SXY0 + 2u];
+            data[SXY0 + 2u] = value;
+            break;
+        case IRGB:
+            for (uint32_t i = 0u; i < 3u; ++i) {
+                data[IR0 + 1u + i] = ((value >> (5u * i)) & 0x1Fu) << 7u;
+            }
+            break;
+        case ORGB:
+        case LZCR:
+            break;
+        case LZCS:
+            data[LZCS] = value;
+            data[LZCR] = LeadingSignBits(value);
+            break;
+        default:
+            data[r] = value;
+            break;
+    }
+}
+
+uint32_t GTE::ReadControl(uint32_t r) const { return control[r]; }
+
+void GTE::WriteControl(uint32_t r, uint32_t value) {
+    switch (r) {
+        case 4u: case 12u: case 20u:
+        case H: case DQA: case ZSF3: case ZSF4:
+            // H is unsigned but reads back sign extended like the others
+            control[r] = SignExtend16(value);
+            break;
+        case FLAG:
+            control[FLAG] = value & FLAG_WRITABLE;
+            End();
+            break;
+        default:
+            control[r] = value;
+            break;
+    }
+}
+
+void GTE::Rtps(uint32_t opcode) {
+    Begin();
+    RotateTranslatePerspective(0u, Shift(opcode), Lm(opcode), true);
+    End();
+}
+
+void GTE::Rtpt(uint32_t opcode) {
+    Begin();
+    for (uint32_t v = 0u; v < 3u; ++v) {
+        RotateTranslatePerspective(v, Shift(opcode), Lm(opcode), v == 2u);
+    }
+    End();
+}
+
+void GTE::Nclip(uint32_t) {
+    // MAC0 = SX0*SY1 + SX1*SY2 + SX2*SY0 - SX0*SY2 - SX1*SY0 - SX2*SY1
+    Begin();
+    int64_t x[3];
+    int64_t y[3];
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        x[i] = static_cast<int16_t>(data[SXY0 + i]);
+        y[i] = static_cast<int16_t>(data[SXY0 + i] >> 16u);
+    }
+    SetMac0(x[0] * y[1] + x[1] * y[2] + x[2] * y[0] - x[0] * y[2] - x[1] * y[0] - x[2] * y[1]);
+    End();
+}
+
+void GTE::Op(uint32_t opcode) {
+    // Cross product of IR with the diagonal of the rotation matrix
+    Begin();
+    int32_t matrix[9];
+    Matrix(RT, matrix);
+    const int64_t d1 = matrix[0];
+    const int64_t d2 = matrix[4];
+    const int64_t d3 = matrix[8];
+    const int64_t ir1 = Ir(1u);
+    const int64_t ir2 = Ir(2u);
+    const int64_t ir3 = Ir(3u);
+    SetMacIr(1u, ir3 * d2 - ir2 * d3, Shift(opcode), Lm(opcode));
+    SetMacIr(2u, ir1 * d3 - ir3 * d1, Shift(opcode), Lm(opcode));
+    SetMacIr(3u, ir2 * d1 - ir1 * d2, Shift(opcode), Lm(opcode));
+    End();
+}
+
+void GTE::Dpcs(uint32_t opcode) {
+    Begin();
+    DepthCue(data[RGBC], Shift(opcode), Lm(opcode));
+    End();
+}
+
+void GTE::Dpct(uint32_t opcode) {
+    // Each step pushes onto the color FIFO so RGB0 moves along
+    Begin();
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        DepthCue(data[RGB0], Shift(opcode), Lm(opcode));
+    }
+    End();
+}
+
+void GTE::Intpl(uint32_t opcode) {
+    Begin();
+    InterpolateColor(
+        int64_t { Ir(1u) } << 12u,
+        int64_t { Ir(2u) } << 12u,
+        int64_t { Ir(3u) } << 12u,
+        Shift(opcode), Lm(opcode));
+    PushColor();
+    End();
+}
+
+void GTE::Mvmva(uint32_t opcode) {
+    Begin();
+    const uint32_t mx = (opcode >> 17u) & 3u;
+    const uint32_t v = (opcode >> 15u) & 3u;
+    const uint32_t cv = (opcode >> 13u) & 3u;
+    int32_t matrix[9];
+    if (mx == 3u) {
+        // There is no fourth matrix, the hardware reads a mixture of registers
+        int32_t rotation[9];
+        Matrix(RT, rotation);
+        const int32_t red = static_cast<int32_t>(data[RGBC] & 0xFFu) << 4u;
+        const int32_t garbage[9] = {
+            -red, red, Ir(0u),
+            rotation[2], rotation[2], rotation[2],
+            rotation[4], rotation[4], rotation[4] };
+        std::copy(garbage, garbage + 9, matrix);
+    } else {
+        Matrix(RT + 8u * mx, matrix);
+    }
+    const int32_t vector[3] = { Vector(v, 0u), Vector(v, 1u), Vector(v, 2u) };
+    int64_t translation[3] = { 0, 0, 0 };
+    if (cv != 3u) {
+        Translation(TR + 8u * cv, translation);
+    }
+    int64_t mac[3];
+    if (cv == 2u) {
+        // The far color only reaches the first product, whose result is
+        // thrown away leaving behind nothing but its flags
+        const int32_t first[9] = { matrix[0], 0, 0, matrix[3], 0, 0, matrix[6], 0, 0 };
+        Transform(mac, first, vector, translation);
+        matrix[0] = matrix[3] = matrix[6] = 0;
+        std::fill(translation, translation + 3, 0);
+    }
+    Transform(mac, matrix, vector, translation);
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        SetMacIr(i + 1u, mac[i], Shift(opcode), Lm(opcode));
+    }
+    End();
+}
+
+void GTE::Ncds(uint32_t opcode) {
+    Begin();
+    NormalColorDepth(0u, Shift(opcode), Lm(opcode));
+    End();
+}
+
+void GTE::Ncdt(uint32_t opcode) {
+    Begin();
+    for (uint32_t v = 0u; v < 3u; ++v) {
+        NormalColorDepth(v, Shift(opcode), Lm(opcode));
+    }
+    End();
+}
+
+void GTE::Cdp(uint32_t opcode) {
+    Begin();
+    ColorMatrix(Shift(opcode), Lm(opcode));
+    InterpolateColor(
+        (Color(0u) * Ir(1u)) << 4u,
+        (Color(1u) * Ir(2u)) << 4u,
+        (Color(2u) * Ir(3u)) << 4u,
+        Shift(opcode), Lm(opcode));
+    PushColor();
+    End();
+}
+
+void GTE::Nccs(uint32_t opcode) {
+    Begin();
+    NormalColorColor(0u, Shift(opcode), Lm(opcode));
+    End();
+}
+
+void GTE::Ncct(uint32_t opcode) {
+    Begin();
+    for (uint32_t v = 0u; v < 3u; ++v) {
+        NormalColorColor(v, Shift(opcode), Lm(opcode));
+    }
+    End();
+}
+
+void GTE::Cc(uint32_t opcode) {
+    Begin();
+    ColorMatrix(Shift(opcode), Lm(opcode));
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        SetMacIr(i + 1u, (Color(i) * Ir(i + 1u)) << 4u, Shift(opcode), Lm(opcode));
+    }
+    PushColor();
+    End();
+}
+
+void GTE::Ncs(uint32_t opcode) {
+    Begin();
+    NormalColor(0u, Shift(opcode), Lm(opcode));
+    End();
+}
+
+void GTE::Nct(uint32_t opcode) {
+    Begin();
+    for (uint32_t v = 0u; v < 3u; ++v) {
+        NormalColor(v, Shift(opcode), Lm(opcode));
+    }
+    End();
+}
+
+void GTE::Sqr(uint32_t opcode) {
+    Begin();
+    for (uint32_t i = 1u; i <= 3u; ++i) {
+        const int64_t ir = Ir(i);
+        SetMacIr(i, ir * ir, Shift(opcode), Lm(opcode));
+    }
+    End();
+}
+
+void GTE::Dcpl(uint32_t opcode) {
+    Begin();
+    InterpolateColor(
+        (Color(0u) * Ir(1u)) << 4u,
+        (Color(1u) * Ir(2u)) << 4u,
+        (Color(2u) * Ir(3u)) << 4u,
+        Shift(opcode), Lm(opcode));
+    PushColor();
+    End();
+}
+
+void GTE::Avsz3(uint32_t) {
+    Begin();
+    const int64_t sum = int64_t { data[SZ0 + 1u] } + data[SZ0 + 2u] + data[SZ0 + 3u];
+    const int64_t value = static_cast<int16_t>(control[ZSF3]) * sum;
+    SetMac0(value);
+    const int64_t otz = value >> 12u;
+    if (otz < 0 || otz > 0xFFFF) {
+        control[FLAG] |= FLAG_SZ_SATURATED;
+    }
+    data[OTZ] = static_cast<uint32_t>(std::clamp<int64_t>(otz, 0, 0xFFFF));
+    End();
+}
+
+void GTE::Avsz4(uint32_t) {
+    Begin();
+    const int64_t sum = int64_t { data[SZ0] } + data[SZ0 + 1u] + data[SZ0 + 2u] + data[SZ0 + 3u];
+    const int64_t value = static_cast<int16_t>(control[ZSF4]) * sum;
+    SetMac0(value);
+    const int64_t otz = value >> 12u;
+    if (otz < 0 || otz > 0xFFFF) {
+        control[FLAG] |= FLAG_SZ_SATURATED;
+    }
+    data[OTZ] = static_cast<uint32_t>(std::clamp<int64_t>(otz, 0, 0xFFFF));
+    End();
+}
+
+void GTE::Gpf(uint32_t opcode) {
+    Begin();
+    for (uint32_t i = 1u; i <= 3u; ++i) {
+        SetMacIr(i, int64_t { Ir(0u) } * Ir(i), Shift(opcode), Lm(opcode));
+    }
+    PushColor();
+    End();
+}
+
+void GTE::Gpl(uint32_t opcode) {
+    Begin();
+    const uint32_t shift = Shift(opcode);
+    for (uint32_t i = 1u; i <= 3u; ++i) {
+        const int64_t mac = static_cast<int32_t>(data[MAC0 + i]);
+        SetMacIr(i, mac * (int64_t { 1 } << shift) + int64_t { Ir(0u) } * Ir(i), shift, Lm(opcode));
+    }
+    PushColor();
+    End();
+}
+
+void GTE::Reserved(uint32_t) {}
+
+void GTE::Begin() {
+    control[FLAG] = 0u;
+}
+
+void GTE::End() {
+    if (control[FLAG] & FLAG_ERROR_MASK) {
+        control[FLAG] |= FLAG_ERROR;
+    }
+}
+
+void GTE::Transform(int64_t* out, const int32_t* matrix, const int32_t* vector, const int64_t* translation) {
+    TransformInput input { };
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        input.translation[i] = translation[i];
+        input.vector[i] = vector[i];
+        for (uint32_t j = 0u; j < 3u; ++j) {
+            input.columns[j][i] = matrix[3u * i + j];
+        }
+    }
+    control[FLAG] |= SelectedKernels().transform(out, input);
+}
+
+void GTE::SetMacIr(uint32_t i, int64_t value, uint32_t shift, bool lm) {
+    SetMac(i, value, shift);
+    SetIr(i, static_cast<int32_t>(data[MAC0 + i]), lm);
+}
+
+void GTE::SetMac(uint32_t i, int64_t value, uint32_t shift) {
+    control[FLAG] |= MacFlags(i, value);
+    data[MAC0 + i] = static_cast<uint32_t>(value >> shift);
+}
+
+void GTE::SetIr(uint32_t i, int32_t value, bool lm) {
+    const int32_t low = lm ? 0 : -0x8000;
+    if (value < low || value > 0x7FFF) {
+        control[FLAG] |= FLAG_IR_SATURATED >> i;
+    }
+    data[IR0 + i] = static_cast<uint32_t>(std::clamp(value, low, 0x7FFF));
+}
+
+void GTE::SetMac0(int64_t value) {
+    control[FLAG] |= Mac0Flags(value);
+    data[MAC0] = static_cast<uint32_t>(value);
+}
+
+void GTE::SetIr0(int32_t value) {
+    if (value < 0 || value > 0x1000) {
+        control[FLAG] |= FLAG_IR0_SATURATED;
+    }
+    data[IR0] = static_cast<uint32_t>(std::clamp(value, 0, 0x1000));
+}
+
+void GTE::PushScreenXY(int64_t x, int64_t y) {
+    if (x < -0x400 || x > 0x3FF) {
+        control[FLAG] |= FLAG_SX_SATURATED;
+    }
+    if (y < -0x400 || y > 0x3FF) {
+        control[FLAG] |= FLAG_SY_SATURATED;
+    }
+    const auto sx = static_cast<uint32_t>(std::clamp<int64_t>(x, -0x400, 0x3FF));
+    const auto sy = static_cast<uint32_t>(std::clamp<int64_t>(y, -0x400, 0x3FF));
+    data[SXY0] = data[SXY0 + 1u];
+    data[SXY0 + 1u] = data[SXY0 + 2u];
+    data[SXY0 + 2u] = (sx & 0xFFFFu) | (sy << 16u);
+}
+
+void GTE::PushScreenZ(int32_t z) {
+    if (z < 0 || z > 0xFFFF) {
+        control[FLAG] |= FLAG_SZ_SATURATED;
+    }
+    data[SZ0] = data[SZ0 + 1u];
+    data[SZ0 + 1u] = data[SZ0 + 2u];
+    data[SZ0 + 2u] = data[SZ0 + 3u];
+    data[SZ0 + 3u] = static_cast<uint32_t>(std::clamp(z, 0, 0xFFFF));
+}
+
+void GTE::PushColor() {
+    // The code byte of RGBC passes straight through
+    uint32_t color = data[RGBC] & 0xFF000000u;
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        const int32_t value = static_cast<int32_t>(data[MAC0 + 1u + i]) >> 4;
+        if (value < 0 || value > 0xFF) {
+            control[FLAG] |= FLAG_COLOR_SATURATED >> (i + 1u);
+        }
+        color |= static_cast<uint32_t>(std::clamp(value, 0, 0xFF)) << (8u * i);
+    }
+    data[RGB0] = data[RGB0 + 1u];
+    data[RGB0 + 1u] = data[RGB0 + 2u];
+    data[RGB0 + 2u] = color;
+}
+
+void GTE::RotateTranslatePerspective(uint32_t v, uint32_t shift, bool lm, bool last) {
+    int32_t matrix[9];
+    int64_t translation[3];
+    Matrix(RT, matrix);
+    Translation(TR, translation);
+    const int32_t vector[3] = { Vector(v, 0u), Vector(v, 1u), Vector(v, 2u) };
+    int64_t mac[3];
+    Transform(mac, matrix, vector, translation);
+    SetMacIr(1u, mac[0], shift, lm);
+    SetMacIr(2u, mac[1], shift, lm);
+    SetMac(3u, mac[2], shift);
+    // IR3 is saturated from MAC3 as usual but its flag only
+    // looks at MAC3 SAR 12 whatever the sf bit says
+    const auto z = static_cast<int32_t>(mac[2] >> 12u);
+    if (z < -0x8000 || z > 0x7FFF) {
+        control[FLAG] |= FLAG_IR_SATURATED >> 3u;
+    }
+    data[IR0 + 3u] = static_cast<uint32_t>(std::clamp(static_cast<int32_t>(data[MAC0 + 3u]), lm ? 0 : -0x8000, 0x7FFF));
+    PushScreenZ(z);
+    // Perspective divide
+    const uint32_t h = control[H] & 0xFFFFu;
+    const uint32_t sz3 = data[SZ0 + 3u];
+    uint32_t n = 0x1FFFFu;
+    if (h < 2u * sz3) {
+        n = UnrDivide(h, sz3);
+    } else {
+        control[FLAG] |= FLAG_DIVIDE_OVERFLOW;
+    }
+    const int64_t x = int64_t { n } * Ir(1u) + static_cast<int32_t>(control[OFX]);
+    const int64_t y = int64_t { n } * Ir(2u) + static_cast<int32_t>(control[OFY]);
+    control[FLAG] |= Mac0Flags(x) | Mac0Flags(y);
+    PushScreenXY(x >> 16u, y >> 16u);
+    if (last) {
+        const int64_t depth = int64_t { n } * static_cast<int16_t>(control[DQA]) + static_cast<int32_t>(control[DQB]);
+        SetMac0(depth);
+        SetIr0(static_cast<int32_t>(depth >> 12u));
+    }
+}
+
+void GTE::Light(const int32_t* vector, uint32_t shift, bool lm) {
+    // IR = LLM * V, then IR = BK + LCM * IR
+    int32_t matrix[9];
+    const int64_t none[3] = { 0, 0, 0 };
+    int64_t mac[3];
+    Matrix(LLM, matrix);
+    Transform(mac, matrix, vector, none);
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        SetMacIr(i + 1u, mac[i], shift, lm);
+    }
+    ColorMatrix(shift, lm);
+}
+
+void GTE::ColorMatrix(uint32_t shift, bool lm) {
+    int32_t matrix[9];
+    int64_t translation[3];
+    int64_t mac[3];
+    Matrix(LCM, matrix);
+    Translation(BK, translation);
+    const int32_t vector[3] = { Ir(1u), Ir(2u), Ir(3u) };
+    Transform(mac, matrix, vector, translation);
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        SetMacIr(i + 1u, mac[i], shift, lm);
+    }
+}
+
+void GTE::InterpolateColor(int64_t mac1, int64_t mac2, int64_t mac3, uint32_t shift, bool lm) {
+    // MAC = MAC + (FC - MAC) * IR0, the difference is always saturated as if lm were clear
+    const int64_t mac[3] = { mac1, mac2, mac3 };
+    int64_t far[3];
+    Translation(FC, far);
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        SetMacIr(i + 1u, far[i] - mac[i], shift, false);
+    }
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        SetMacIr(i + 1u, int64_t { Ir(i + 1u) } * Ir(0u) + mac[i], shift, lm);
+    }
+}
+
+void GTE::NormalColorDepth(uint32_t v, uint32_t shift, bool lm) {
+    const int32_t vector[3] = { Vector(v, 0u), Vector(v, 1u), Vector(v, 2u) };
+    Light(vector, shift, lm);
+    InterpolateColor(
+        (Color(0u) * Ir(1u)) << 4u,
+        (Color(1u) * Ir(2u)) << 4u,
+        (Color(2u) * Ir(3u)) << 4u,
+        shift, lm);
+    PushColor();
+}
+
+void GTE::NormalColorColor(uint32_t v, uint32_t shift, bool lm) {
+    const int32_t vector[3] = { Vector(v, 0u), Vector(v, 1u), Vector(v, 2u) };
+    Light(vector, shift, lm);
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        SetMacIr(i + 1u, (Color(i) * Ir(i + 1u)) << 4u, shift, lm);
+    }
+    PushColor();
+}
+
+void GTE::NormalColor(uint32_t v, uint32_t shift, bool lm) {
+    const int32_t vector[3] = { Vector(v, 0u), Vector(v, 1u), Vector(v, 2u) };
+    Light(vector, shift, lm);
+    PushColor();
+}
+
+void GTE::DepthCue(uint32_t color, uint32_t shift, bool lm) {
+    InterpolateColor(
+        int64_t { color & 0xFFu } << 16u,
+        int64_t { (color >> 8u) & 0xFFu } << 16u,
+        int64_t { (color >> 16u) & 0xFFu } << 16u,
+        shift, lm);
+    PushColor();
+}
+
+int32_t GTE::Vector(uint32_t v, uint32_t axis) const {
+    // The fourth vector is IR1-3
+    if (v == 3u) {
+        return Ir(axis + 1u);
+    }
+    switch (axis) {
+        case 0u: return static_cast<int16_t>(data[2u * v]);
+        case 1u: return static_cast<int16_t>(data[2u * v] >> 16u);
+        default: return static_cast<int32_t>(data[2u * v + 1u]);
+    }
+}
+
+int32_t GTE::Ir(uint32_t i) const {
+    return static_cast<int32_t>(data[IR0 + i]);
+}
+
+void GTE::Matrix(uint32_t base, int32_t* matrix) const {
+    // Nine 16 bit elements packed two to a register
+    for (uint32_t k = 0u; k < 9u; ++k) {
+        matrix[k] = static_cast<int16_t>(control[base + k / 2u] >> (16u * (k & 1u)));
+    }
+}
+
+void GTE::Translation(uint32_t base, int64_t* translation) const {
+    for (uint32_t i = 0u; i < 3u; ++i) {
+        translation[i] = int64_t { static_cast<int32_t>(control[base + i]) } * 0x1000;
+    }
+}
+
+int64_t GTE::Color(uint32_t i) const {
+    return (data[RGBC] >> (8u * i)) & 0xFFu;
+}
+
+GteCommand GteCommandAt(uint32_t function) {
+    return COMMANDS[function & (GTE_COMMAND_COUNT - 1u)];
+}
+
+const char* GteInstructionSet() {
+    return SelectedKernels().name;
+}
+
+}
@@ -0,0 +1,376 @@
+#include "GdbJit.h"
+
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <mutex>
+#include <utility>
+
+// The interface a debugger looks for, names and layout are fixed by GDB
+extern "C" {
+
+enum JitActions : uint32_t {
+    JIT_NOACTION = 0u,
+    JIT_REGISTER_FN = 1u,
+    JIT_UNREGISTER_FN = 2u
+};
+
+struct jit_code_entry {
+    jit_code_entry* next_entry;
+    jit_code_entry* prev_entry;
+    const char* symfile_addr;
+    uint64_t symfile_size;
+};
+
+struct jit_descriptor {
+    uint32_t version;
+    uint32_t action_flag;
+    jit_code_entry* relevant_entry;
+    jit_code_entry* first_entry;
+};
+
+// The debugger sets a breakpoint here and reads the descriptor when it is hit
+void __attribute__((noinline)) __jit_debug_register_code() {
+    asm volatile("" ::: "memory");
+}
+
+jit_descriptor __jit_debug_descriptor = { 1u, JIT_NOACTION, nullptr, nullptr };
+
+}
+
+namespace rbrown {
+
+struct GdbJitObject {
+    jit_code_entry entry;
+    std::vector<uint8_t> image;
+};
+
+namespace {
+
+constexpr size_t BATCH_SIZE = 64u;
+
+// Sections of each object in the order of their headers
+constexpr uint16_t SECTION_TEXT = 1u;
+constexpr uint16_t SECTION_EH_FRAME = 2u;
+constexpr uint16_t SECTION_SHSTRTAB = 3u;
+constexpr uint16_t SECTION_STRTAB = 4u;
+constexpr uint16_t SECTION_SYMTAB = 5u;
+constexpr uint16_t SECTION_COUNT = 6u;
+
+constexpr uint8_t DW_CFA_ADVANCE_LOC = 0x40u;
+constexpr uint8_t DW_CFA_ADVANCE_LOC4 = 0x04u;
+constexpr uint8_t DW_CFA_RESTORE = 0xC0u;
+constexpr uint8_t DW_CFA_REMEMBER_STATE = 0x0Au;
+constexpr uint8_t DW_CFA_RESTORE_STATE = 0x0Bu;
+constexpr uint8_t DW_CFA_OFFSET = 0x80u;
+constexpr uint8_t DW_CFA_DEF_CFA = 0x0Cu;
+constexpr uint8_t DW_CFA_DEF_CFA_REGISTER = 0x0Du;
+constexpr uint8_t DW_CFA_DEF_CFA_OFFSET = 0x0Eu;
+constexpr uint8_t DW_CFA_NOP = 0x00u;
+// Code addresses are written out in full, every unwinder understands those
+constexpr uint8_t DW_EH_PE_ABSPTR = 0x00u;
+
+// DWARF numbering of the x64 registers the prologue touches
+constexpr uint8_t DWARF_RBX = 3u;
+constexpr uint8_t DWARF_RBP = 6u;
+constexpr uint8_t DWARF_RSP = 7u;
+constexpr uint8_t DWARF_R12 = 12u;
+constexpr uint8_t DWARF_R13 = 13u;
+constexpr uint8_t DWARF_R14 = 14u;
+constexpr uint8_t DWARF_R15 = 15u;
+constexpr uint8_t DWARF_RETURN_ADDRESS = 16u;
+
+// Offsets with data alignment -8 so the return address is at CFA-8 and each push is 8 further down
+constexpr uint8_t DATA_ALIGNMENT = 0x78u;
+
+// Each registration goes through the one descriptor in the process
+std::mutex descriptorMutex;
+
+template <typename T>
+void Append(std::vector<uint8_t>& bytes, const T& value) {
+    const auto* data = reinterpret_cast<const uint8_t*>(&value);
+    bytes.insert(bytes.end(), data, data + sizeof(T));
+}
+
+template <typename T>
+void Overwrite(std::vector<uint8_t>& bytes, size_t position, const T& value) {
+    std::memcpy(bytes.data() + position, &value, sizeof(T));
+}
+
+void Align(std::vector<uint8_t>& bytes, size_t alignment, uint8_t fill) {
+    while (bytes.size() % alignment != 0u) {
+        bytes.push_back(fill);
+    }
+}
+
+size_t AppendString(std::vector<uint8_t>& bytes, const std::string& string) {
+    const size_t position = bytes.size();
+    bytes.insert(bytes.end(), string.begin(), string.end());
+    bytes.push_back(0u);
+    return position;
+}
+
+void AdvanceTo(std::vector<uint8_t>& frames, uint32_t& location, uint32_t offset) {
+    const uint32_t delta = offset - location;
+    if (delta < 0x40u) {
+        frames.push_back(static_cast<uint8_t>(DW_CFA_ADVANCE_LOC | delta));
+    } else {
+        frames.push_back(DW_CFA_ADVANCE_LOC4);
+        Append(frames, delta);
+    }
+    location = offset;
+}
+
+void AppendBlockFrame(std::vector<uint8_t>& frames, const GdbJitSymbol& symbol) {
+    // Follows EmitBlockPrologue, every push is two bytes with its REX prefix and the move three
+    // Anything before the prologue, like a profiler's counter, leaves the frame as it was on entry
+    uint32_t location = 0u;
+    AdvanceTo(frames, location, static_cast<uint32_t>(symbol.prologue + 2u));
+    frames.insert(frames.end(), {
+        DW_CFA_DEF_CFA_OFFSET, 16u, DW_CFA_OFFSET | DWARF_RBP, 2u,
+        DW_CFA_ADVANCE_LOC | 3u, DW_CFA_DEF_CFA_REGISTER, DWARF_RBP,
+        DW_CFA_ADVANCE_LOC | 2u, DW_CFA_OFFSET | DWARF_RBX, 3u,
+        DW_CFA_ADVANCE_LOC | 2u, DW_CFA_OFFSET | DWARF_R13, 4u,
+        DW_CFA_ADVANCE_LOC | 2u, DW_CFA_OFFSET | DWARF_R14, 5u,
+        DW_CFA_ADVANCE_LOC | 2u, DW_CFA_OFFSET | DWARF_R15, 6u,
+    });
+    location += 11u;
+    // EmitBlockEpilogue pops what the prologue pushed while RBP still locates the frame,
+    // only its RET runs with everything restored and the return address at RSP
+    for (const uint32_t ret : symbol.returns) {
+        AdvanceTo(frames, location, ret);
+        frames.insert(frames.end(), {
+            DW_CFA_REMEMBER_STATE, DW_CFA_DEF_CFA, DWARF_RSP, 8u,
+            DW_CFA_RESTORE | DWARF_RBP, DW_CFA_RESTORE | DWARF_RBX,
+            DW_CFA_RESTORE | DWARF_R13, DW_CFA_RESTORE | DWARF_R14, DW_CFA_RESTORE | DWARF_R15,
+        });
+        AdvanceTo(frames, location, ret + 1u);
+        frames.push_back(DW_CFA_RESTORE_STATE);
+    }
+}
+
+void AppendTimingFrame(std::vector<uint8_t>& frames, const GdbJitSymbol& symbol) {
+    // Follows BlockProfiler::EmitEntry, two pushes then eight bytes to keep the call aligned
+    // and the same undone in reverse, four bytes to add to RSP then two for each pop
+    uint32_t location = 0u;
+    frames.insert(frames.end(), {
+        DW_CFA_ADVANCE_LOC | 2u, DW_CFA_DEF_CFA_OFFSET, 16u, DW_CFA_OFFSET | DWARF_RBX, 2u,
+        DW_CFA_ADVANCE_LOC | 2u, DW_CFA_DEF_CFA_OFFSET, 24u, DW_CFA_OFFSET | DWARF_R12, 3u,
+        DW_CFA_ADVANCE_LOC | 4u, DW_CFA_DEF_CFA_OFFSET, 32u,
+    });
+    location += 8u;
+    for (const uint32_t ret : symbol.returns) {
+        AdvanceTo(frames, location, ret - 4u);
+        frames.insert(frames.end(), {
+            DW_CFA_REMEMBER_STATE, DW_CFA_DEF_CFA_OFFSET, 24u,
+            DW_CFA_ADVANCE_LOC | 2u, DW_CFA_DEF_CFA_OFFSET, 16u, DW_CFA_RESTORE | DWARF_R12,
+            DW_CFA_ADVANCE_LOC | 2u, DW_CFA_DEF_CFA_OFFSET, 8u, DW_CFA_RESTORE | DWARF_RBX,
+            DW_CFA_ADVANCE_LOC | 1u, DW_CFA_RESTORE_STATE,
+        });
+        location = ret + 1u;
+    }
+}
+
+void AppendFrameEntry(std::vector<uint8_t>& frames, const GdbJitSymbol& symbol) {
+    const size_t start = frames.size();
+    Append(frames, uint32_t { 0u });
+    Append(frames, static_cast<uint32_t>(frames.size()));
+    Append(frames, static_cast<uint64_t>(symbol.code));
+    Append(frames, static_cast<uint64_t>(symbol.size));
+    frames.push_back(0u);
+    // An entry that only jumps to its block keeps the frame it was called with
+    if (symbol.frame == FRAME_BLOCK) {
+        AppendBlockFrame(frames, symbol);
+    } else if (symbol.frame == FRAME_TIMING) {
+        AppendTimingFrame(frames, symbol);
+    }
+    Align(frames, sizeof(uint64_t), DW_CFA_NOP);
+    Overwrite(frames, start, static_cast<uint32_t>(frames.size() - start - sizeof(uint32_t)));
+}
+
+std::vector<uint8_t> BuildFrames(const std::vector<GdbJitSymbol>& symbols) {
+    // One CIE for the state on entry then an FDE per block at its absolute address
+    std::vector<uint8_t> frames;
+    Append(frames, uint32_t { 0u });
+    Append(frames, uint32_t { 0u });
+    frames.insert(frames.end(), {
+        1u, 'z', 'R', 0u, 1u, DATA_ALIGNMENT, DWARF_RETURN_ADDRESS,
+        1u, DW_EH_PE_ABSPTR,
+        DW_CFA_DEF_CFA, DWARF_RSP, 8u, DW_CFA_OFFSET | DWARF_RETURN_ADDRESS, 1u,
+    });
+    Align(frames, sizeof(uint64_t), DW_CFA_NOP);
+    Overwrite(frames, 0u, static_cast<uint32_t>(frames.size() - sizeof(uint32_t)));
+    for (const GdbJitSymbol& symbol : symbols) {
+        AppendFrameEntry(frames, symbol);
+    }
+    Append(frames, uint32_t { 0u });
+    return frames;
+}
+
+Elf64_Shdr Section(uint32_t name, uint32_t type, uint64_t flags, uint64_t address, uint64_t offset, uint64_t size) {
+    Elf64_Shdr header { };
+    header.sh_name = name;
+    header.sh_type = type;
+    header.sh_flags = flags;
+    header.sh_addr = address;
+    header.sh_offset = offset;
+    header.sh_size = size;
+    header.sh_addralign = 1u;
+    return header;
+}
+
+std::vector<uint8_t> BuildObject(const std::vector<GdbJitSymbol>& symbols) {
+    // A relocatable object whose .text has no contents, only the address of the code
+    const uintptr_t text = symbols.front().code;
+    const uintptr_t textEnd = symbols.back().code + symbols.back().size;
+
+    std::vector<uint8_t> names;
+    const size_t textName = AppendString(names, ".text");
+    const size_t frameName = AppendString(names, ".eh_frame");
+    const size_t shstrtabName = AppendString(names, ".shstrtab");
+    const size_t strtabName = AppendString(names, ".strtab");
+    const size_t symtabName = AppendString(names, ".symtab");
+
+    std::vector<uint8_t> strings { 0u };
+    std::vector<uint8_t> table;
+    Append(table, Elf64_Sym { });
+    for (const GdbJitSymbol& symbol : symbols) {
+        Elf64_Sym entry { };
+        entry.st_name = static_cast<uint32_t>(AppendString(strings, symbol.name));
+        entry.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+        entry.st_shndx = SECTION_TEXT;
+        entry.st_value = symbol.code - text;
+        entry.st_size = symbol.size;
+        Append(table, entry);
+    }
+    const std::vector<uint8_t> frames = BuildFrames(symbols);
+
+    std::vector<uint8_t> image(sizeof(Elf64_Ehdr));
+    const size_t frameOffset = image.size();
+    image.insert(image.end(), frames.begin(), frames.end());
+    const size_t namesOffset = image.size();
+    image.insert(image.end(), names.begin(), names.end());
+    const size_t stringsOffset = image.size();
+    image.insert(image.end(), strings.begin(), strings.end());
+    Align(image, sizeof(uint64_t), 0u);
+    const size_t tableOffset = image.size();
+    image.insert(image.end(), table.begin(), table.end());
+    Align(image, sizeof(uint64_t), 0u);
+    const size_t sectionsOffset = image.size();
+
+    Append(image, Elf64_Shdr { });
+    Append(image, Section(textName, SHT_NOBITS, SHF_ALLOC | SHF_EXECINSTR, text, 0u, textEnd - text));
+    Append(image, Section(frameName, SHT_PROGBITS, SHF_ALLOC, 0u, frameOffset, frames.size()));
+    Append(image, Section(shstrtabName, SHT_STRTAB, 0u, 0u, namesOffset, names.size()));
+    Append(image, Section(strtabName, SHT_STRTAB, 0u, 0u, stringsOffset, strings.size()));
+    Elf64_Shdr symtab = Section(symtabName, SHT_SYMTAB, 0u, 0u, tableOffset, table.size());
+    symtab.sh_link = SECTION_STRTAB;
+    // Every symbol after the null one is global
+    symtab.sh_info = 1u;
+    symtab.sh_entsize = sizeof(Elf64_Sym);
+    symtab.sh_addralign = sizeof(uint64_t);
+    Append(image, symtab);
+
+    Elf64_Ehdr header { };
+    std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_type = ET_REL;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_shoff = sectionsOffset;
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = SECTION_COUNT;
+    header.e_shstrndx = SECTION_SHSTRTAB;
+    Overwrite(image, 0u, header);
+    return image;
+}
+
+}
+
+GdbJit::GdbJit() :
+    pending { },
+    registered { } {}
+
+GdbJit::~GdbJit() {
+    std::lock_guard lock(descriptorMutex);
+    for (const auto& object : registered) {
+        jit_code_entry* entry = &object->entry;
+        if (entry->prev_entry) {
+            entry->prev_entry->next_entry = entry->next_entry;
+        } else {
+            __jit_debug_descriptor.first_entry = entry->next_entry;
+        }
+        if (entry->next_entry) {
+            entry->next_entry->prev_entry = entry->prev_entry;
+        }
+        __jit_debug_descriptor.relevant_entry = entry;
+        __jit_debug_descriptor.action_flag = JIT_UNREGISTER_FN;
+        __jit_debug_register_code();
+    }
+}
+
+void GdbJit::RecordBlock(uint32_t pc, uintptr_t code, size_t size, size_t prologue, const std::vector<uintptr_t>& returns) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "mips_blk_%08x", pc);
+    Record(name, code, size, FRAME_BLOCK, prologue, returns);
+}
+
+void GdbJit::RecordTrace(uint32_t pc, uintptr_t code, size_t size, const std::vector<uintptr_t>& returns) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "mips_trace_%08x", pc);
+    Record(name, code, size, FRAME_BLOCK, 0u, returns);
+}
+
+void GdbJit::RecordEntry(uint32_t pc, uintptr_t code, size_t size, bool timing, const std::vector<uintptr_t>& returns) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "mips_entry_%08x", pc);
+    Record(name, code, size, timing ? FRAME_TIMING : FRAME_JUMP, 0u, returns);
+}
+
+void GdbJit::Record(std::string name, uintptr_t code, size_t size, uint32_t frame, size_t prologue, const std::vector<uintptr_t>& returns) {
+    // A batch covers one run of code so .text can span it
+    if (!pending.empty() && pending.back().code + pending.back().size != code) {
+        Flush();
+    }
+    // The returns may cover more code than this symbol, only its own are kept
+    std::vector<uint32_t> offsets;
+    for (const uintptr_t ret : returns) {
+        if (ret >= code && ret < code + size) {
+            offsets.push_back(static_cast<uint32_t>(ret - code));
+        }
+    }
+    pending.push_back({ std::move(name), code, size, frame, prologue, std::move(offsets) });
+    if (pending.size() >= BATCH_SIZE) {
+        Flush();
+    }
+}
+
+void GdbJit::Flush() {
+    if (pending.empty()) {
+        return;
+    }
+    auto object = std::make_unique<GdbJitObject>();
+    object->image = BuildObject(pending);
+    pending.clear();
+    jit_code_entry* entry = &object->entry;
+    entry->symfile_addr = reinterpret_cast<const char*>(object->image.data());
+    entry->symfile_size = object->image.size();
+    std::lock_guard lock(descriptorMutex);
+    entry->prev_entry = nullptr;
+    entry->next_entry = __jit_debug_descriptor.first_entry;
+    if (entry->next_entry) {
+        entry->next_entry->prev_entry = entry;
+    }
+    __jit_debug_descriptor.first_entry = entry;
+    __jit_debug_descriptor.relevant_entry = entry;
+    __jit_debug_descriptor.action_flag = JIT_REGISTER_FN;
+    __jit_debug_register_code();
+    registered.push_back(std::move(object));
+}
+
+size_t GdbJit::RegisteredCount() const { return registered.size(); }
+
+}
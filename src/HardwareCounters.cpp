@@ -0,0 +1,182 @@
+#include "HardwareCounters.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace rbrown {
+
+namespace {
+
+constexpr const char* COUNTER_NAMES[HW_COUNTER_COUNT] = {
+    "instructions",
+    "cycles",
+    "itlb misses",
+    "branch misses",
+    "l1i misses",
+};
+
+constexpr uint64_t CacheMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8u) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u);
+}
+
+int OpenCounter(uint32_t type, uint64_t config) {
+    perf_event_attr attr { };
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1u;
+    attr.exclude_kernel = 1u;
+    attr.exclude_hv = 1u;
+    // Enabled and running times let a multiplexed count be scaled to the whole slice
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+HardwareReading ReadCounter(int file) {
+    HardwareReading reading { };
+    if (read(file, &reading, sizeof(reading)) != static_cast<ssize_t>(sizeof(reading))) {
+        return HardwareReading { };
+    }
+    return reading;
+}
+
+uint64_t SliceCount(const HardwareReading& start, const HardwareReading& end) {
+    // The times are cumulative like the count so the slice is scaled by its own share of them
+    // A slice the counter never ran in, or a failed read, counts nothing
+    if (end.running <= start.running || end.count < start.count) {
+        return 0u;
+    }
+    const uint64_t count = end.count - start.count;
+    const uint64_t enabled = end.enabled - start.enabled;
+    const uint64_t running = end.running - start.running;
+    if (enabled == running) {
+        return count;
+    }
+    return static_cast<uint64_t>(static_cast<double>(count) * static_cast<double>(enabled) / static_cast<double>(running));
+}
+
+void Accumulate(HardwareSample& sample, const HardwareSample& slice) {
+    for (uint32_t counter = 0u; counter < HW_COUNTER_COUNT; ++counter) {
+        sample.values[counter] += slice.values[counter];
+    }
+}
+
+double PerThousand(uint64_t value, uint64_t instructions) {
+    return instructions == 0u ? 0.0 : 1000.0 * static_cast<double>(value) / static_cast<double>(instructions);
+}
+
+template<typename... Args>
+void AppendLine(std::string& report, const char* format, Args... args) {
+    char line[160];
+    std::snprintf(line, sizeof(line), format, args...);
+    report += line;
+}
+
+void AppendSample(std::string& report, const HardwareSample& sample) {
+    const uint64_t instructions = sample.values[HW_INSTRUCTIONS];
+    const uint64_t cycles = sample.values[HW_CYCLES];
+    AppendLine(report, "    %" PRIu64 " instructions %" PRIu64 " cycles ipc %.2f\n", instructions, cycles,
+               cycles == 0u ? 0.0 : static_cast<double>(instructions) / static_cast<double>(cycles));
+    AppendLine(report, "    per 1000 instructions: itlb %.3f branch %.3f l1i %.3f\n",
+               PerThousand(sample.values[HW_ITLB_MISSES], instructions),
+               PerThousand(sample.values[HW_BRANCH_MISSES], instructions),
+               PerThousand(sample.values[HW_L1I_MISSES], instructions));
+}
+
+}
+
+HardwareCounters::HardwareCounters() :
+    files { },
+    starts { },
+    ranges { },
+    total { } {
+    files[HW_INSTRUCTIONS] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    files[HW_CYCLES] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    files[HW_ITLB_MISSES] = OpenCounter(PERF_TYPE_HW_CACHE, CacheMiss(PERF_COUNT_HW_CACHE_ITLB));
+    files[HW_BRANCH_MISSES] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    files[HW_L1I_MISSES] = OpenCounter(PERF_TYPE_HW_CACHE, CacheMiss(PERF_COUNT_HW_CACHE_L1I));
+}
+
+HardwareCounters::~HardwareCounters() {
+    for (const int file : files) {
+        if (file >= 0) {
+            close(file);
+        }
+    }
+}
+
+bool HardwareCounters::Available(uint32_t counter) const { return files[counter] >= 0; }
+
+void HardwareCounters::Begin() {
+    // Resetting would only zero the count and leave the times running on, so the
+    // counters keep going and each slice is the difference from where it began
+    for (uint32_t counter = 0u; counter < HW_COUNTER_COUNT; ++counter) {
+        if (files[counter] >= 0) {
+            starts[counter] = ReadCounter(files[counter]);
+            ioctl(files[counter], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void HardwareCounters::End(const GuestRange& range) {
+    HardwareSample slice { };
+    for (uint32_t counter = 0u; counter < HW_COUNTER_COUNT; ++counter) {
+        if (files[counter] >= 0) {
+            ioctl(files[counter], PERF_EVENT_IOC_DISABLE, 0);
+            slice.values[counter] = SliceCount(starts[counter], ReadCounter(files[counter]));
+        }
+    }
+    Accumulate(total, slice);
+    // A slice that ran nothing has no range to charge
+    if (range.start >= range.end) {
+        return;
+    }
+    const uint64_t key = (static_cast<uint64_t>(range.start) << 32u) | range.end;
+    auto [it, inserted] = ranges.try_emplace(key, HardwareRange { range, 0u, { } });
+    ++it->second.slices;
+    Accumulate(it->second.sample, slice);
+}
+
+HardwareSample HardwareCounters::Total() const { return total; }
+
+std::vector<HardwareRange> HardwareCounters::TopRanges(uint32_t counter, size_t n) const {
+    std::vector<HardwareRange> top;
+    top.reserve(ranges.size());
+    for (const auto& [key, range] : ranges) {
+        top.push_back(range);
+    }
+    n = std::min(n, top.size());
+    std::partial_sort(top.begin(), top.begin() + n, top.end(), [counter](const HardwareRange& a, const HardwareRange& b) {
+        return a.sample.values[counter] > b.sample.values[counter];
+    });
+    top.resize(n);
+    return top;
+}
+
+std::string HardwareCounters::Report(size_t n) const {
+    std::string report;
+    report += "counters:";
+    for (uint32_t counter = 0u; counter < HW_COUNTER_COUNT; ++counter) {
+        AppendLine(report, " %s%s", COUNTER_NAMES[counter], Available(counter) ? "" : " (unavailable)");
+    }
+    report += "\ntotal\n";
+    AppendSample(report, total);
+    for (const uint32_t counter : { HW_CYCLES, HW_ITLB_MISSES, HW_L1I_MISSES }) {
+        if (!Available(counter)) {
+            continue;
+        }
+        AppendLine(report, "top %zu of %zu guest ranges by %s\n", n, ranges.size(), COUNTER_NAMES[counter]);
+        for (const HardwareRange& range : TopRanges(counter, n)) {
+            AppendLine(report, "0x%08x - 0x%08x %" PRIu64 " slices\n", range.range.start, range.range.end, range.slices);
+            AppendSample(report, range.sample);
+        }
+    }
+    return report;
+}
+
+}
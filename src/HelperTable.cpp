@@ -0,0 +1,41 @@
+#include "HelperTable.h"
+#include "Bios.h"
+#include "EmitterX64.h"
+#include "MIPS.h"
+
+namespace rbrown {
+
+HelperTable::HelperTable() : entries{ 0 } {
+    Register(HELPER_WRITE_PC, AddressOf(WritePC));
+    Register(HELPER_ENTER_EXCEPTION, AddressOf(EnterException));
+    Register(HELPER_LOAD_WORD, AddressOf(LoadWord));
+    Register(HELPER_STORE_WORD, AddressOf(StoreWord));
+    Register(HELPER_SET_LOAD_DELAY_VALUE, AddressOf(SetLoadDelayValue));
+    Register(HELPER_SET_LOAD_DELAY_REGISTER, AddressOf(SetLoadDelayRegister));
+    Register(HELPER_SET_LOAD_DELAY_SLOT, AddressOf(SetLoadDelaySlot));
+    Register(HELPER_SET_LOAD_DELAY_SLOT_NEXT, AddressOf(SetLoadDelaySlotNext));
+    Register(HELPER_SET_BRANCH_DELAY_SLOT, AddressOf(SetBranchDelaySlot));
+    Register(HELPER_RETIRE_LOAD, AddressOf(RetireLoad));
+    Register(HELPER_RETIRE_BRANCH, AddressOf(RetireBranch));
+    for (uint32_t i = 0u; i < DECODE_TABLE_SIZE; ++i) {
+        Register(HELPER_INTERPRET + i, reinterpret_cast<uintptr_t>(InstructionAt(i).interpret));
+    }
+    for (uint32_t i = 0u; i < GTE_COMMAND_COUNT; ++i) {
+        Register(HELPER_GTE_COMMAND + i, reinterpret_cast<uintptr_t>(GteCommandAt(i)));
+    }
+    Register(HELPER_CALL_BIOS, AddressOf(CallBios));
+}
+
+uintptr_t HelperTable::Address(uint32_t helper) const { return entries[helper]; }
+
+const uintptr_t* HelperTable::Entries() const { return entries; }
+
+uint32_t HelperTable::Offset(uint32_t helper) {
+    return helper * sizeof(uintptr_t);
+}
+
+void HelperTable::Register(uint32_t helper, uintptr_t address) {
+    entries[helper] = address;
+}
+
+}
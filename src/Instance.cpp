@@ -0,0 +1,245 @@
+#include "Instance.h"
+#include "Decoder.h"
+#include "HardwareCounters.h"
+
+#include <algorithm>
+
+namespace rbrown {
+
+namespace {
+
+// An edge taken this often starts a trace and the path it follows
+// carries on through successors taken at least half as often
+constexpr uint32_t HOT_EDGE_COUNT = 64u;
+constexpr size_t MAX_TRACE_BLOCKS = 4u;
+
+constexpr uint32_t RETURN_ADDRESS_REGISTER = 31u;
+
+bool Overlaps(uint32_t address, uint32_t length, uint32_t pc, uint32_t instructions) {
+    // Worked out in 64 bits so ranges that reach the top of the address space don't wrap
+    const uint64_t end = uint64_t{ address } + length;
+    const uint64_t blockEnd = uint64_t{ pc } + 4u * uint64_t{ instructions };
+    return pc < end && address < blockEnd;
+}
+
+void ClassifyExit(const Memory& memory, uint32_t pc, uint32_t length, DispatchEntry& entry) {
+    // Only the branch before the delay slot decides where the block goes
+    entry.exit = 0u;
+    entry.returnAddress = pc + 4u * length;
+    // BIOS functions run natively return to $31 as if they ended with JR $31
+    if (IsBiosVector(pc)) {
+        entry.exit = EXIT_RETURN;
+        return;
+    }
+    if (length < 2u) {
+        return;
+    }
+    const uint32_t opcode = memory.ReadWord(pc + 4u * (length - 2u));
+    const uint32_t flags = DecodeInstruction(opcode).flags;
+    if (!(flags & IS_BRANCH)) {
+        return;
+    }
+    if ((flags & WRITES_RA) || ((flags & WRITES_RD) && InstructionRd(opcode) == RETURN_ADDRESS_REGISTER)) {
+        entry.exit = EXIT_CALL;
+    } else if (InstructionOp(opcode) == 0x00u && InstructionFunction(opcode) == 0x08u && InstructionRs(opcode) == RETURN_ADDRESS_REGISTER) {
+        entry.exit = EXIT_RETURN;
+    }
+}
+
+}
+
+Instance::Instance(CodeCache& c, size_t memorySize, bool hugePages) :
+    cache { c },
+    memory { memorySize, hugePages },
+    processor { },
+    scheduler { processor },
+    bios { },
+    interpreter { processor },
+    dispatch { },
+    traces { },
+    returns { },
+    returnTop { 0u },
+    previous { nullptr },
+    counters { nullptr } {
+    processor.AttachMemory(&memory);
+    processor.AttachBios(&bios);
+}
+
+R3051& Instance::Processor() { return processor; }
+
+Memory& Instance::Ram() { return memory; }
+
+Scheduler& Instance::Events() { return scheduler; }
+
+Bios& Instance::Hle() { return bios; }
+
+bool Instance::Run(uint32_t count) {
+    bool ran;
+    if (!counters) {
+        ran = Dispatch(count, nullptr);
+    } else {
+        GuestRange range { UINT32_MAX, 0u };
+        counters->Begin();
+        ran = Dispatch(count, &range);
+        counters->End(range);
+    }
+    cache.FlushDebugInfo();
+    return ran;
+}
+
+bool Instance::Dispatch(uint32_t count, GuestRange* range) {
+    const uintptr_t* helpers = cache.Helpers().Entries();
+    for (uint32_t i = 0u; i < count; ++i) {
+        if (processor.GetDowncount() <= 0) {
+            scheduler.RunEvents();
+        }
+        if (processor.ExitRequested()) {
+            ServiceExitRequest(&processor);
+        }
+        const uint32_t pc = processor.ReadPC();
+        DispatchEntry* entry = previous ? Follow(*previous, pc) : Lookup(pc);
+        if (!entry) {
+            previous = nullptr;
+            return false;
+        }
+        entry->code(&processor, helpers);
+        if (range) {
+            range->start = std::min(range->start, entry->block.pc);
+            range->end = std::max(range->end, entry->block.pc + 4u * entry->block.length);
+        }
+        if (entry->exit & EXIT_CALL) {
+            returnTop = (returnTop + 1u) % RETURN_STACK_SIZE;
+            returns[returnTop] = { entry->returnAddress, entry };
+        }
+        CountEdge(*entry, processor.ReadPC());
+        previous = entry;
+    }
+    return true;
+}
+
+void Instance::AttachCounters(HardwareCounters* c) {
+    counters = c;
+}
+
+uint32_t Instance::Interpret(uint32_t count) {
+    return interpreter.Run(count);
+}
+
+void Instance::Invalidate(uint32_t address, uint32_t length) {
+    // Drop every decoded page and block that overlaps the written range
+    interpreter.Invalidate(address, length);
+    for (auto it = traces.begin(); it != traces.end();) {
+        const auto& blocks = it->second.blocks;
+        const bool overlaps = std::any_of(blocks.begin(), blocks.end(), [address, length](const TraceBlock& block) {
+            return Overlaps(address, length, block.pc, block.length);
+        });
+        if (overlaps) {
+            // The first block goes with it so that it is looked up again without the trace
+            dispatch.erase(it->first);
+            it = traces.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = dispatch.begin(); it != dispatch.end();) {
+        const CachedBlock& block = it->second.block;
+        if (Overlaps(address, length, block.pc, block.length)) {
+            it = dispatch.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Predictions may point at entries that have gone
+    for (auto& [pc, entry] : dispatch) {
+        entry.returnEntry = nullptr;
+        entry.lastEntry = nullptr;
+    }
+    returns.fill({ 0u, nullptr });
+    previous = nullptr;
+}
+
+size_t Instance::TraceCount() const {
+    return static_cast<size_t>(std::count_if(traces.begin(), traces.end(), [](const auto& trace) { return trace.second.code != nullptr; }));
+}
+
+DispatchEntry* Instance::Lookup(uint32_t pc) {
+    auto it = dispatch.find(pc);
+    if (it == dispatch.end()) {
+        const CachedBlock block = cache.Lookup(memory, pc);
+        if (!block.code) {
+            return nullptr;
+        }
+        DispatchEntry entry { block, block.code, 0u, 0u, nullptr, 0u, nullptr, { } };
+        ClassifyExit(memory, block.pc, block.length, entry);
+        it = dispatch.emplace(pc, entry).first;
+    }
+    return &it->second;
+}
+
+DispatchEntry* Instance::Follow(DispatchEntry& from, uint32_t pc) {
+    // A wrong guess only costs the lookup it would have taken anyway
+    if (from.exit & EXIT_RETURN) {
+        const ReturnPrediction prediction = returns[returnTop];
+        returnTop = (returnTop + RETURN_STACK_SIZE - 1u) % RETURN_STACK_SIZE;
+        if (!prediction.caller || prediction.address != pc) {
+            return Lookup(pc);
+        }
+        // A trace formed since may have moved where the caller returns to
+        DispatchEntry*& entry = prediction.caller->returnEntry;
+        if (!entry || entry->block.pc != pc) {
+            entry = Lookup(pc);
+        }
+        return entry;
+    }
+    if (from.lastEntry && from.lastTarget == pc) {
+        return from.lastEntry;
+    }
+    from.lastTarget = pc;
+    from.lastEntry = Lookup(pc);
+    return from.lastEntry;
+}
+
+void Instance::CountEdge(DispatchEntry& from, uint32_t to) {
+    EdgeCounts& counts = from.edges;
+    for (uint32_t i = 0u; i < 2u; ++i) {
+        if (counts.counts[i] == 0u || counts.targets[i] == to) {
+            counts.targets[i] = to;
+            if (++counts.counts[i] == HOT_EDGE_COUNT) {
+                FormTrace(from.block.pc);
+            }
+            return;
+        }
+    }
+}
+
+void Instance::FormTrace(uint32_t head) {
+    // A failed attempt is remembered too so that it isn't tried again
+    if (traces.count(head) != 0u) {
+        return;
+    }
+    // Only the block at a BIOS vector calls the native function so the path never runs through one
+    std::vector<uint32_t> path { head };
+    for (uint32_t pc = head; path.size() < MAX_TRACE_BLOCKS && !IsBiosVector(pc);) {
+        const auto it = dispatch.find(pc);
+        if (it == dispatch.end()) {
+            break;
+        }
+        const EdgeCounts& counts = it->second.edges;
+        const uint32_t hottest = counts.counts[1] > counts.counts[0] ? 1u : 0u;
+        const uint32_t next = counts.targets[hottest];
+        if (counts.counts[hottest] < HOT_EDGE_COUNT / 2u || IsBiosVector(next) || std::find(path.begin(), path.end(), next) != path.end()) {
+            break;
+        }
+        path.push_back(next);
+        pc = next;
+    }
+    const CachedTrace& trace = traces.emplace(head, cache.CompileTrace(memory, path)).first->second;
+    if (trace.code) {
+        // The trace leaves the way its last block does
+        DispatchEntry& entry = dispatch.at(head);
+        entry.code = trace.code;
+        ClassifyExit(memory, trace.blocks.back().pc, trace.blocks.back().length, entry);
+    }
+}
+
+}
@@ -0,0 +1,33 @@
+#include "Interpreter.h"
+#include "Decoder.h"
+#include "Memory.h"
+#include "MIPS.h"
+
+namespace rbrown {
+
+void Step(R3051* r3051) {
+    const uint32_t pc = r3051->ReadPC();
+    const Memory* memory = r3051->GetMemory();
+    const uint32_t opcode = memory ? memory->ReadWord(pc) : 0u;
+    DecodeInstruction(opcode).interpret(r3051, opcode);
+    RetireLoad(r3051);
+    // Handlers only write the PC when they take an exception
+    if (r3051->ReadPC() != pc) {
+        r3051->SetLoadDelaySlot(false);
+        r3051->SetLoadDelaySlotNext(false);
+        return;
+    }
+    RetireBranch(r3051, pc);
+}
+
+uint32_t Run(R3051* r3051, uint32_t count) {
+    // Never stop between a branch and its delay slot
+    uint32_t executed = 0u;
+    while (executed < count || r3051->GetBranchDelaySlot()) {
+        Step(r3051);
+        ++executed;
+    }
+    return executed;
+}
+
+}
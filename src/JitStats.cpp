@@ -0,0 +1,129 @@
+#include "JitStats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cstdio>
+#include <unistd.h>
+
+namespace rbrown {
+
+namespace {
+
+constexpr size_t MAX_PATH = 64u;
+
+constexpr const char* METRIC_NAMES[JIT_STAT_COUNT] = {
+    "guest instructions",
+    "host bytes",
+    "bytes per instruction",
+    "helper calls",
+    "fallbacks",
+    "labels",
+    "fixups",
+    "compile ns",
+};
+
+JitHistogram EmptyHistogram() {
+    return JitHistogram { 0u, 0u, UINT64_MAX, 0u, { } };
+}
+
+void Add(JitHistogram& histogram, uint64_t value) {
+    const auto bucket = std::min<uint32_t>(static_cast<uint32_t>(std::bit_width(value)), JIT_HISTOGRAM_BUCKETS - 1u);
+    ++histogram.samples;
+    histogram.total += value;
+    histogram.minimum = std::min(histogram.minimum, value);
+    histogram.maximum = std::max(histogram.maximum, value);
+    ++histogram.buckets[bucket];
+}
+
+template<typename... Args>
+void AppendLine(std::string& report, const char* format, Args... args) {
+    char line[128];
+    std::snprintf(line, sizeof(line), format, args...);
+    report += line;
+}
+
+}
+
+JitStats::JitStats(uint64_t interval) :
+    dumpInterval { interval },
+    compiles { 0u },
+    histograms { },
+    mutex { } {
+    histograms.fill(EmptyHistogram());
+}
+
+void JitStats::Record(const JitCompile& compile) {
+    std::lock_guard lock(mutex);
+    ++compiles;
+    Add(histograms[JIT_STAT_GUEST_INSTRUCTIONS], compile.guestInstructions);
+    Add(histograms[JIT_STAT_HOST_BYTES], compile.hostBytes);
+    // Rounded to the nearest byte, the totals give the exact overall ratio
+    Add(histograms[JIT_STAT_BYTES_PER_INSTRUCTION],
+        (compile.hostBytes + compile.guestInstructions / 2u) / std::max<uint64_t>(compile.guestInstructions, 1u));
+    Add(histograms[JIT_STAT_HELPER_CALLS], compile.helperCalls);
+    Add(histograms[JIT_STAT_FALLBACKS], compile.fallbacks);
+    Add(histograms[JIT_STAT_LABELS], compile.labels);
+    Add(histograms[JIT_STAT_FIXUPS], compile.fixUps);
+    Add(histograms[JIT_STAT_NANOSECONDS], compile.nanoseconds);
+    if (dumpInterval != 0u && compiles % dumpInterval == 0u) {
+        Dump();
+    }
+}
+
+uint64_t JitStats::CompileCount() const {
+    std::lock_guard lock(mutex);
+    return compiles;
+}
+
+JitHistogram JitStats::Histogram(uint32_t metric) const {
+    std::lock_guard lock(mutex);
+    return histograms[metric];
+}
+
+std::string JitStats::Report() const {
+    std::lock_guard lock(mutex);
+    return ReportLocked();
+}
+
+std::string JitStats::ReportLocked() const {
+    std::string report;
+    AppendLine(report, "%" PRIu64 " compiles\n", compiles);
+    const JitHistogram& guest = histograms[JIT_STAT_GUEST_INSTRUCTIONS];
+    const JitHistogram& host = histograms[JIT_STAT_HOST_BYTES];
+    if (guest.total != 0u) {
+        AppendLine(report, "%.2f host bytes per guest instruction overall\n",
+                   static_cast<double>(host.total) / static_cast<double>(guest.total));
+    }
+    for (uint32_t metric = 0u; metric < JIT_STAT_COUNT; ++metric) {
+        const JitHistogram& histogram = histograms[metric];
+        if (histogram.samples == 0u) {
+            continue;
+        }
+        AppendLine(report, "%s: mean %.2f min %" PRIu64 " max %" PRIu64 "\n", METRIC_NAMES[metric],
+                   static_cast<double>(histogram.total) / static_cast<double>(histogram.samples),
+                   histogram.minimum, histogram.maximum);
+        for (uint32_t bucket = 0u; bucket < JIT_HISTOGRAM_BUCKETS; ++bucket) {
+            if (histogram.buckets[bucket] == 0u) {
+                continue;
+            }
+            const uint64_t low = bucket == 0u ? 0u : uint64_t { 1u } << (bucket - 1u);
+            const uint64_t high = bucket == 0u ? 0u : (uint64_t { 1u } << bucket) - 1u;
+            AppendLine(report, "    %10" PRIu64 " - %-10" PRIu64 " %" PRIu64 "\n", low, high, histogram.buckets[bucket]);
+        }
+    }
+    return report;
+}
+
+void JitStats::Dump() const {
+    // Rewritten whole each time so the file always holds one complete report
+    char path[MAX_PATH];
+    std::snprintf(path, sizeof(path), "/tmp/jit-stats-%d.txt", static_cast<int>(getpid()));
+    if (FILE* file = std::fopen(path, "w")) {
+        const std::string report = ReportLocked();
+        std::fwrite(report.data(), 1u, report.size(), file);
+        std::fclose(file);
+    }
+}
+
+}
@@ -0,0 +1,231 @@
+#include "Lockstep.h"
+#include "MIPS.h"
+
+#include <immintrin.h>
+
+namespace rbrown {
+
+namespace {
+
+// Kernels operate on whole rows of LOCKSTEP_LANES registers
+// Add returns a mask of the lanes that overflowed, those lanes are not written
+struct Kernels {
+    void (*addu)(uint32_t*, const uint32_t*, const uint32_t*);
+    void (*subu)(uint32_t*, const uint32_t*, const uint32_t*);
+    void (*addiu)(uint32_t*, const uint32_t*, uint32_t);
+    uint32_t (*add)(uint32_t*, const uint32_t*, const uint32_t*);
+    const char* name;
+};
+
+void ScalarAddu(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; ++i) { d[i] = s[i] + t[i]; }
+}
+
+void ScalarSubu(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; ++i) { d[i] = s[i] - t[i]; }
+}
+
+void ScalarAddiu(uint32_t* d, const uint32_t* s, uint32_t immediate) {
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; ++i) { d[i] = s[i] + immediate; }
+}
+
+uint32_t ScalarAdd(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    uint32_t overflow = 0u;
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; ++i) {
+        const uint32_t result = s[i] + t[i];
+        if ((~(s[i] ^ t[i]) & (s[i] ^ result)) >> 31u) {
+            overflow |= 1u << i;
+        } else {
+            d[i] = result;
+        }
+    }
+    return overflow;
+}
+
+__attribute__((target("avx2")))
+void Avx2Addu(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; i += 8u) {
+        const __m256i vs = _mm256_load_si256(reinterpret_cast<const __m256i*>(s + i));
+        const __m256i vt = _mm256_load_si256(reinterpret_cast<const __m256i*>(t + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(d + i), _mm256_add_epi32(vs, vt));
+    }
+}
+
+__attribute__((target("avx2")))
+void Avx2Subu(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; i += 8u) {
+        const __m256i vs = _mm256_load_si256(reinterpret_cast<const __m256i*>(s + i));
+        const __m256i vt = _mm256_load_si256(reinterpret_cast<const __m256i*>(t + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(d + i), _mm256_sub_epi32(vs, vt));
+    }
+}
+
+__attribute__((target("avx2")))
+void Avx2Addiu(uint32_t* d, const uint32_t* s, uint32_t immediate) {
+    const __m256i vi = _mm256_set1_epi32(static_cast<int>(immediate));
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; i += 8u) {
+        const __m256i vs = _mm256_load_si256(reinterpret_cast<const __m256i*>(s + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(d + i), _mm256_add_epi32(vs, vi));
+    }
+}
+
+__attribute__((target("avx2")))
+uint32_t Avx2Add(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    uint32_t overflow = 0u;
+    for (uint32_t i = 0u; i < LOCKSTEP_LANES; i += 8u) {
+        const __m256i vs = _mm256_load_si256(reinterpret_cast<const __m256i*>(s + i));
+        const __m256i vt = _mm256_load_si256(reinterpret_cast<const __m256i*>(t + i));
+        const __m256i vd = _mm256_load_si256(reinterpret_cast<const __m256i*>(d + i));
+        const __m256i result = _mm256_add_epi32(vs, vt);
+        // Overflow when the operands agree in sign and the result does not
+        const __m256i sign = _mm256_andnot_si256(_mm256_xor_si256(vs, vt), _mm256_xor_si256(vs, result));
+        const __m256i mask = _mm256_srai_epi32(sign, 31);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(d + i), _mm256_blendv_epi8(result, vd, mask));
+        overflow |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(mask))) << i;
+    }
+    return overflow;
+}
+
+__attribute__((target("avx512f")))
+void Avx512Addu(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    const __m512i vs = _mm512_load_si512(s);
+    const __m512i vt = _mm512_load_si512(t);
+    _mm512_store_si512(d, _mm512_add_epi32(vs, vt));
+}
+
+__attribute__((target("avx512f")))
+void Avx512Subu(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    const __m512i vs = _mm512_load_si512(s);
+    const __m512i vt = _mm512_load_si512(t);
+    _mm512_store_si512(d, _mm512_sub_epi32(vs, vt));
+}
+
+__attribute__((target("avx512f")))
+void Avx512Addiu(uint32_t* d, const uint32_t* s, uint32_t immediate) {
+    const __m512i vs = _mm512_load_si512(s);
+    _mm512_store_si512(d, _mm512_add_epi32(vs, _mm512_set1_epi32(static_cast<int>(immediate))));
+}
+
+__attribute__((target("avx512f")))
+uint32_t Avx512Add(uint32_t* d, const uint32_t* s, const uint32_t* t) {
+    const __m512i vs = _mm512_load_si512(s);
+    const __m512i vt = _mm512_load_si512(t);
+    const __m512i result = _mm512_add_epi32(vs, vt);
+    const __m512i sign = _mm512_andnot_si512(_mm512_xor_si512(vs, vt), _mm512_xor_si512(vs, result));
+    const __mmask16 overflow = _mm512_cmplt_epi32_mask(sign, _mm512_setzero_si512());
+    _mm512_mask_store_epi32(d, static_cast<__mmask16>(~overflow), result);
+    return overflow;
+}
+
+Kernels SelectKernels() {
+    if (__builtin_cpu_supports("avx512f")) {
+        return Kernels { Avx512Addu, Avx512Subu, Avx512Addiu, Avx512Add, "AVX-512" };
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernels { Avx2Addu, Avx2Subu, Avx2Addiu, Avx2Add, "AVX2" };
+    }
+    return Kernels { ScalarAddu, ScalarSubu, ScalarAddiu, ScalarAdd, "Scalar" };
+}
+
+const Kernels& SelectedKernels() {
+    static const Kernels kernels = SelectKernels();
+    return kernels;
+}
+
+}
+
+LockstepBatch::LockstepBatch() : registers { }, lanes { }, active { 0u } {}
+
+void LockstepBatch::Gather(R3051* const* processors, uint32_t count) {
+    active = 0u;
+    for (uint32_t lane = 0u; lane < LOCKSTEP_LANES; ++lane) {
+        lanes[lane] = lane < count ? processors[lane] : nullptr;
+        for (uint32_t r = 0u; r < 32u; ++r) {
+            registers[r][lane] = lanes[lane] ? lanes[lane]->ReadRegister(r) : 0u;
+        }
+        if (lanes[lane]) {
+            active |= 1u << lane;
+        }
+    }
+}
+
+void LockstepBatch::Scatter() const {
+    for (uint32_t lane = 0u; lane < LOCKSTEP_LANES; ++lane) {
+        if (active & (1u << lane)) {
+            ScatterLane(lane);
+        }
+    }
+}
+
+void LockstepBatch::ScatterLane(uint32_t lane) const {
+    for (uint32_t r = 1u; r < 32u; ++r) {
+        lanes[lane]->WriteRegister(r, registers[r][lane]);
+    }
+}
+
+void LockstepBatch::Diverge(uint32_t lane) {
+    if (active & (1u << lane)) {
+        ScatterLane(lane);
+        active &= ~(1u << lane);
+    }
+}
+
+uint32_t LockstepBatch::ActiveLanes() const { return active; }
+
+R3051* LockstepBatch::Lane(uint32_t lane) const { return lanes[lane]; }
+
+uint32_t* LockstepBatch::Registers(uint32_t r) { return registers[r]; }
+
+// Lanes that have diverged are still computed but never written back
+// Writes to $zero are discarded for every lane
+
+void LockstepAddu(LockstepBatch* batch, uint32_t opcode) {
+    const uint32_t rd = InstructionRd(opcode);
+    if (rd == 0u) {
+        return;
+    }
+    SelectedKernels().addu(
+        batch->Registers(rd),
+        batch->Registers(InstructionRs(opcode)),
+        batch->Registers(InstructionRt(opcode)));
+}
+
+void LockstepSubu(LockstepBatch* batch, uint32_t opcode) {
+    const uint32_t rd = InstructionRd(opcode);
+    if (rd == 0u) {
+        return;
+    }
+    SelectedKernels().subu(
+        batch->Registers(rd),
+        batch->Registers(InstructionRs(opcode)),
+        batch->Registers(InstructionRt(opcode)));
+}
+
+void LockstepAddiu(LockstepBatch* batch, uint32_t opcode) {
+    const uint32_t rt = InstructionRt(opcode);
+    if (rt == 0u) {
+        return;
+    }
+    SelectedKernels().addiu(
+        batch->Registers(rt),
+        batch->Registers(InstructionRs(opcode)),
+        InstructionImmediateExtended(opcode));
+}
+
+uint32_t LockstepAdd(LockstepBatch* batch, uint32_t opcode) {
+    // Returns the active lanes that overflowed, these must leave the batch
+    // and take their exception on the scalar interpreter
+    const uint32_t rd = InstructionRd(opcode);
+    alignas(64) uint32_t discard[LOCKSTEP_LANES] { };
+    const uint32_t overflow = SelectedKernels().add(
+        rd ? batch->Registers(rd) : discard,
+        batch->Registers(InstructionRs(opcode)),
+        batch->Registers(InstructionRt(opcode)));
+    return overflow & batch->ActiveLanes();
+}
+
+const char* LockstepInstructionSet() {
+    return SelectedKernels().name;
+}
+
+}
@@ -1,4 +1,7 @@
 #include "MIPS.h"
+#include "Memory.h"
+
+#include <cstddef>
 
 namespace rbrown {
 
@@ -8,8 +11,13 @@ uint32_t OverflowAdd(uint32_t x, uint32_t y, uint32_t result) {
     return (~(x ^ y) & (x ^ result)) >> 31u;
 }
 
+uint32_t OverflowSub(uint32_t x, uint32_t y, uint32_t result) {
+    return ((x ^ y) & (x ^ result)) >> 31u;
+}
+
 }
 
+constexpr uint32_t BADVADDR = 8;
 constexpr uint32_t SR = 12;
 constexpr uint32_t CAUSE = 13;
 constexpr uint32_t EPC = 14;
@@ -35,14 +43,68 @@ uint32_t COP0::EnterException(uint32_t code, uint32_t epc, uint32_t branch) {
     return BOOT_EXCEPTION_VECTOR;
 }
 
+void COP0::ReturnFromException() {
+    WriteRegisterMasked(SR, 0x0000000Fu, ReadRegister(SR) >> 2u);
+}
+
+void COP0::SetInterruptLines(uint32_t lines) {
+    // The six hardware lines appear as IP2 to IP7
+    WriteRegisterMasked(CAUSE, 0x0000FC00u, lines << 10u);
+}
+
+bool COP0::InterruptPending() const {
+    // Interrupts must be enabled by IEc and unmasked in IM
+    const uint32_t sr = ReadRegister(SR);
+    return (sr & 1u) && (sr & ReadRegister(CAUSE) & 0x0000FF00u);
+}
+
 R3051::R3051() :
     registers { 0 },
     pc { RESET_EXCEPTION_VECTOR },
+    hi { 0 },
+    lo { 0 },
+    downcount { 0 },
+    exitRequest { 0u },
+    interruptLines { 0u },
     cop0 { },
+    cop2 { },
     loadDelaySlot { false },
     loadDelaySlotNext { false },
     loadDelayRegister { 0 },
-    loadDelayValue { 0 } {}
+    loadDelayValue { 0 },
+    branchTarget { 0 },
+    branchDelaySlot { false },
+    branchDelaySlotNext { false },
+    memory { nullptr },
+    bios { nullptr } {}
+
+size_t R3051::RegisterOffset(uint32_t r) {
+    return offsetof(R3051, registers) + r * sizeof(uint32_t);
+}
+
+size_t R3051::PCOffset() {
+    return offsetof(R3051, pc);
+}
+
+size_t R3051::HiOffset() {
+    return offsetof(R3051, hi);
+}
+
+size_t R3051::LoOffset() {
+    return offsetof(R3051, lo);
+}
+
+size_t R3051::Cop2Offset() {
+    return offsetof(R3051, cop2);
+}
+
+size_t R3051::DowncountOffset() {
+    return offsetof(R3051, downcount);
+}
+
+size_t R3051::ExitRequestOffset() {
+    return offsetof(R3051, exitRequest);
+}
 
 uintptr_t R3051::RegisterAddress(uint32_t r) const {
     return reinterpret_cast<uintptr_t>(&registers[r]);
@@ -50,19 +112,57 @@ uintptr_t R3051::RegisterAddress(uint32_t r) const {
 
 uint32_t R3051::ReadRegister(uint32_t r) const { return registers[r]; }
 uint32_t R3051::ReadPC() const { return pc; }
+uint32_t R3051::ReadHi() const { return hi; }
+uint32_t R3051::ReadLo() const { return lo; }
+int32_t R3051::GetDowncount() const { return downcount; }
+bool R3051::ExitRequested() const { return exitRequest.load(std::memory_order_relaxed) != 0u; }
+uint32_t R3051::GetInterruptLines() const { return interruptLines.load(std::memory_order_acquire); }
 bool R3051::GetLoadDelaySlot() const { return loadDelaySlot; }
 bool R3051::GetLoadDelaySlotNext() const { return loadDelaySlotNext; }
 uint32_t R3051::GetLoadDelayRegister() const { return loadDelayRegister; }
 uint32_t R3051::GetLoadDelayValue() const { return loadDelayValue; }
+uint32_t R3051::GetBranchTarget() const { return branchTarget; }
+bool R3051::GetBranchDelaySlot() const { return branchDelaySlot; }
+bool R3051::GetBranchDelaySlotNext() const { return branchDelaySlotNext; }
+
+void R3051::WriteRegister(uint32_t r, uint32_t v) {
+    // Writes to $zero are discarded
+    if (r != 0u) {
+        registers[r] = v;
+    }
+}
 
-void R3051::WriteRegister(uint32_t r, uint32_t v) { registers[r] = v; }
 void R3051::WritePC(uint32_t v) { pc = v; }
+void R3051::WriteHi(uint32_t v) { hi = v; }
+void R3051::WriteLo(uint32_t v) { lo = v; }
+void R3051::SetDowncount(int32_t v) { downcount = v; }
+void R3051::RequestExit() { exitRequest.store(1u, std::memory_order_release); }
+void R3051::ClearExitRequest() { exitRequest.store(0u, std::memory_order_relaxed); }
+
+void R3051::AssertInterrupt(uint32_t line) {
+    interruptLines.fetch_or(1u << line, std::memory_order_release);
+    RequestExit();
+}
+
+void R3051::DeassertInterrupt(uint32_t line) {
+    interruptLines.fetch_and(~(1u << line), std::memory_order_release);
+    RequestExit();
+}
 void R3051::SetLoadDelaySlot(bool v) { loadDelaySlot = v; }
 void R3051::SetLoadDelaySlotNext(bool v) { loadDelaySlotNext = v; }
 void R3051::SetLoadDelayRegister(uint32_t v) { loadDelayRegister = v; }
 void R3051::SetLoadDelayValue(uint32_t v) { loadDelayValue = v; }
+void R3051::SetBranchTarget(uint32_t v) { branchTarget = v; }
+void R3051::SetBranchDelaySlot(bool v) { branchDelaySlot = v; }
+void R3051::SetBranchDelaySlotNext(bool v) { branchDelaySlotNext = v; }
 
 COP0& R3051::Cop0() { return cop0; }
+GTE& R3051::Cop2() { return cop2; }
+
+Memory* R3051::GetMemory() const { return memory; }
+void R3051::AttachMemory(Memory* m) { memory = m; }
+Bios* R3051::GetBios() const { return bios; }
+void R3051::AttachBios(Bios* b) { bios = b; }
 
 uint32_t ReadRegister(R3051* r3051, uint32_t r) { return r3051->ReadRegister(r); }
 uint32_t ReadPC(R3051* r3051) { return r3051->ReadPC(); }
@@ -70,6 +170,7 @@ bool GetLoadDelaySlot(R3051* r3051) { return r3051->GetLoadDelaySlot(); }
 bool GetLoadDelaySlotNext(R3051* r3051) { return r3051->GetLoadDelaySlotNext(); }
 uint32_t GetLoadDelayRegister(R3051* r3051) { return r3051->GetLoadDelayRegister(); }
 uint32_t GetLoadDelayValue(R3051* r3051) { return r3051->GetLoadDelayValue(); }
+bool GetBranchDelaySlot(R3051* r3051) { return r3051->GetBranchDelaySlot(); }
 
 void WriteRegister(R3051* r3051, uint32_t r, uint32_t value) { r3051->WriteRegister(r, value); }
 void WritePC(R3051* r3051, uint32_t pc) { r3051->WritePC(pc); }
@@ -77,11 +178,88 @@ void SetLoadDelaySlot(R3051* r3051, bool v) { r3051->SetLoadDelaySlot(v); }
 void SetLoadDelaySlotNext(R3051* r3051, bool v) { r3051->SetLoadDelaySlotNext(v); }
 void SetLoadDelayRegister(R3051* r3051, uint32_t v) { r3051->SetLoadDelayRegister(v); }
 void SetLoadDelayValue(R3051* r3051, uint32_t v) { r3051->SetLoadDelayValue(v); }
+void SetBranchTarget(R3051* r3051, uint32_t v) { r3051->SetBranchTarget(v); }
+void SetBranchDelaySlot(R3051* r3051, bool v) { r3051->SetBranchDelaySlot(v); }
+void SetBranchDelaySlotNext(R3051* r3051, bool v) { r3051->SetBranchDelaySlotNext(v); }
 
 void EnterException(R3051* r3051, uint32_t code) {
-    const uint32_t epc = ReadPC(r3051);
-    const uint32_t pc = r3051->Cop0().EnterException(code, epc, 0u);
+    // An exception in a branch delay slot restarts at the branch
+    const bool branch = GetBranchDelaySlot(r3051);
+    const uint32_t epc = branch ? ReadPC(r3051) - 4u : ReadPC(r3051);
+    const uint32_t pc = r3051->Cop0().EnterException(code, epc, branch ? 1u : 0u);
     WritePC(r3051, pc);
+    SetBranchDelaySlot(r3051, false);
+    SetBranchDelaySlotNext(r3051, false);
+}
+
+bool ServiceExitRequest(R3051* r3051) {
+    // Only called between instructions so the interrupt is taken cleanly
+    // Returns whether it was
+    r3051->ClearExitRequest();
+    COP0& cop0 = r3051->Cop0();
+    cop0.SetInterruptLines(r3051->GetInterruptLines());
+    if (!cop0.InterruptPending()) {
+        return false;
+    }
+    EnterException(r3051, INTERRUPT);
+    return true;
+}
+
+void RetireLoad(R3051* r3051) {
+    // Write back the load that was in its delay slot and start the next one
+    if (GetLoadDelaySlot(r3051)) {
+        WriteRegister(r3051, GetLoadDelayRegister(r3051), GetLoadDelayValue(r3051));
+    }
+    SetLoadDelaySlot(r3051, GetLoadDelaySlotNext(r3051));
+    SetLoadDelaySlotNext(r3051, false);
+}
+
+void RetireBranch(R3051* r3051, uint32_t pc) {
+    // Move to the branch target once its delay slot has executed
+    WritePC(r3051, GetBranchDelaySlot(r3051) ? r3051->GetBranchTarget() : pc + 4u);
+    SetBranchDelaySlot(r3051, r3051->GetBranchDelaySlotNext());
+    SetBranchDelaySlotNext(r3051, false);
+}
+
+namespace {
+
+void EnterAddressException(R3051* r3051, uint32_t code, uint32_t address) {
+    r3051->Cop0().WriteRegister(BADVADDR, address);
+    EnterException(r3051, code);
+}
+
+void Branch(R3051* r3051, bool taken, uint32_t target) {
+    const uint32_t pc = ReadPC(r3051);
+    SetBranchDelaySlotNext(r3051, true);
+    SetBranchTarget(r3051, taken ? target : pc + 8u);
+}
+
+uint32_t BranchTarget(R3051* r3051, uint32_t opcode) {
+    return ReadPC(r3051) + 4u + (InstructionImmediateExtended(opcode) << 2u);
+}
+
+void DelayedLoad(R3051* r3051, uint32_t r, uint32_t value) {
+    // The load in progress takes effect now that this one has read its operands, as there's
+    // only room for one, unless this one writes the same register and cancels it
+    if (GetLoadDelaySlot(r3051)) {
+        if (GetLoadDelayRegister(r3051) != r) {
+            WriteRegister(r3051, GetLoadDelayRegister(r3051), GetLoadDelayValue(r3051));
+        }
+        SetLoadDelaySlot(r3051, false);
+    }
+    SetLoadDelaySlotNext(r3051, true);
+    SetLoadDelayRegister(r3051, r);
+    SetLoadDelayValue(r3051, value);
+}
+
+uint32_t ReadRegisterBypassed(R3051* r3051, uint32_t r) {
+    // LWL and LWR see the value of a load that is still in its delay slot
+    if (GetLoadDelaySlot(r3051) && GetLoadDelayRegister(r3051) == r) {
+        return GetLoadDelayValue(r3051);
+    }
+    return ReadRegister(r3051, r);
+}
+
 }
 
 uint32_t InstructionFunction(uint32_t opcode) { return opcode & 0x3Fu; }
@@ -93,6 +271,8 @@ uint32_t InstructionImmediate(uint32_t opcode) { return opcode & 0xFFFFu; }
 uint32_t InstructionImmediateExtended(uint32_t opcode) {
     return ((opcode & 0xFFFFu) ^ 0x8000u) - 0x8000u;
 }
+uint32_t InstructionShift(uint32_t opcode) { return (opcode >> 6u) & 0x1Fu; }
+uint32_t InstructionTarget(uint32_t opcode) { return opcode & 0x03FFFFFFu; }
 
 void WriteRegisterRd(R3051* r3051, uint32_t opcode, uint32_t value) {
     WriteRegister(r3051, InstructionRd(opcode), value);
@@ -111,10 +291,60 @@ uint32_t ReadRegisterRs(R3051* r3051, uint32_t opcode) {
 }
 
 bool StoreWord(R3051* r3051, uint32_t virtualAddress, uint32_t value) {
+    if (virtualAddress & 3u) {
+        EnterAddressException(r3051, ADDRESS_ERROR_STORE, virtualAddress);
+        return false;
+    }
+    if (Memory* memory = r3051->GetMemory()) {
+        memory->WriteWord(virtualAddress, value);
+    }
+    return true;
+}
+
+bool StoreHalf(R3051* r3051, uint32_t virtualAddress, uint32_t value) {
+    if (virtualAddress & 1u) {
+        EnterAddressException(r3051, ADDRESS_ERROR_STORE, virtualAddress);
+        return false;
+    }
+    if (Memory* memory = r3051->GetMemory()) {
+        memory->WriteHalf(virtualAddress, value);
+    }
+    return true;
+}
+
+bool StoreByte(R3051* r3051, uint32_t virtualAddress, uint32_t value) {
+    if (Memory* memory = r3051->GetMemory()) {
+        memory->WriteByte(virtualAddress, value);
+    }
     return true;
 }
 
 bool LoadWord(R3051* r3051, uint32_t virtualAddress, uint32_t* value) {
+    if (virtualAddress & 3u) {
+        EnterAddressException(r3051, ADDRESS_ERROR_LOAD, virtualAddress);
+        return false;
+    }
+    if (Memory* memory = r3051->GetMemory()) {
+        *value = memory->ReadWord(virtualAddress);
+    }
+    return true;
+}
+
+bool LoadHalf(R3051* r3051, uint32_t virtualAddress, uint32_t* value) {
+    if (virtualAddress & 1u) {
+        EnterAddressException(r3051, ADDRESS_ERROR_LOAD, virtualAddress);
+        return false;
+    }
+    if (Memory* memory = r3051->GetMemory()) {
+        *value = memory->ReadHalf(virtualAddress);
+    }
+    return true;
+}
+
+bool LoadByte(R3051* r3051, uint32_t virtualAddress, uint32_t* value) {
+    if (Memory* memory = r3051->GetMemory()) {
+        *value = memory->ReadByte(virtualAddress);
+    }
     return true;
 }
 
@@ -173,4 +403,412 @@ void InterpretLw(R3051* r3051, uint32_t opcode) {
         SetLoadDelayValue(r3051, value);
     }
 }
+
+void InterpretSll(R3051* r3051, uint32_t opcode) {
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    WriteRegisterRd(r3051, opcode, t << InstructionShift(opcode));
+}
+
+void InterpretSrl(R3051* r3051, uint32_t opcode) {
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    WriteRegisterRd(r3051, opcode, t >> InstructionShift(opcode));
+}
+
+void InterpretSra(R3051* r3051, uint32_t opcode) {
+    const auto t = static_cast<int32_t>(ReadRegisterRt(r3051, opcode));
+    WriteRegisterRd(r3051, opcode, static_cast<uint32_t>(t >> InstructionShift(opcode)));
+}
+
+void InterpretSllv(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    WriteRegisterRd(r3051, opcode, t << (s & 0x1Fu));
+}
+
+void InterpretSrlv(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    WriteRegisterRd(r3051, opcode, t >> (s & 0x1Fu));
+}
+
+void InterpretSrav(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const auto t = static_cast<int32_t>(ReadRegisterRt(r3051, opcode));
+    WriteRegisterRd(r3051, opcode, static_cast<uint32_t>(t >> (s & 0x1Fu)));
+}
+
+void InterpretJr(R3051* r3051, uint32_t opcode) {
+    Branch(r3051, true, ReadRegisterRs(r3051, opcode));
+}
+
+void InterpretJalr(R3051* r3051, uint32_t opcode) {
+    const uint32_t target = ReadRegisterRs(r3051, opcode);
+    WriteRegisterRd(r3051, opcode, ReadPC(r3051) + 8u);
+    Branch(r3051, true, target);
+}
+
+void InterpretSyscall(R3051* r3051, uint32_t) {
+    EnterException(r3051, SYSCALL);
+}
+
+void InterpretBreak(R3051* r3051, uint32_t) {
+    EnterException(r3051, BREAKPOINT);
+}
+
+void InterpretSub(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    const uint32_t result = s - t;
+    if (OverflowSub(s, t, result)) {
+        EnterException(r3051, ARITHMETIC_OVERFLOW);
+        return;
+    }
+    WriteRegisterRd(r3051, opcode, result);
+}
+
+void InterpretAnd(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRd(r3051, opcode, ReadRegisterRs(r3051, opcode) & ReadRegisterRt(r3051, opcode));
+}
+
+void InterpretOr(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRd(r3051, opcode, ReadRegisterRs(r3051, opcode) | ReadRegisterRt(r3051, opcode));
+}
+
+void InterpretXor(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRd(r3051, opcode, ReadRegisterRs(r3051, opcode) ^ ReadRegisterRt(r3051, opcode));
+}
+
+void InterpretNor(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRd(r3051, opcode, ~(ReadRegisterRs(r3051, opcode) | ReadRegisterRt(r3051, opcode)));
+}
+
+void InterpretSlt(R3051* r3051, uint32_t opcode) {
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    const auto t = static_cast<int32_t>(ReadRegisterRt(r3051, opcode));
+    WriteRegisterRd(r3051, opcode, s < t ? 1u : 0u);
+}
+
+void InterpretSltu(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    WriteRegisterRd(r3051, opcode, s < t ? 1u : 0u);
+}
+
+void InterpretMfhi(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRd(r3051, opcode, r3051->ReadHi());
+}
+
+void InterpretMthi(R3051* r3051, uint32_t opcode) {
+    r3051->WriteHi(ReadRegisterRs(r3051, opcode));
+}
+
+void InterpretMflo(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRd(r3051, opcode, r3051->ReadLo());
+}
+
+void InterpretMtlo(R3051* r3051, uint32_t opcode) {
+    r3051->WriteLo(ReadRegisterRs(r3051, opcode));
+}
+
+void InterpretMult(R3051* r3051, uint32_t opcode) {
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    const auto t = static_cast<int32_t>(ReadRegisterRt(r3051, opcode));
+    const auto result = static_cast<uint64_t>(static_cast<int64_t>(s) * t);
+    r3051->WriteHi(static_cast<uint32_t>(result >> 32u));
+    r3051->WriteLo(static_cast<uint32_t>(result));
+}
+
+void InterpretMultu(R3051* r3051, uint32_t opcode) {
+    const uint64_t s = ReadRegisterRs(r3051, opcode);
+    const uint64_t t = ReadRegisterRt(r3051, opcode);
+    const uint64_t result = s * t;
+    r3051->WriteHi(static_cast<uint32_t>(result >> 32u));
+    r3051->WriteLo(static_cast<uint32_t>(result));
+}
+
+void InterpretDiv(R3051* r3051, uint32_t opcode) {
+    // Division never traps, dividing by zero or overflowing gives fixed results
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    if (t == 0u) {
+        r3051->WriteHi(s);
+        r3051->WriteLo((s & 0x80000000u) ? 1u : 0xFFFFFFFFu);
+    } else if (s == 0x80000000u && t == 0xFFFFFFFFu) {
+        r3051->WriteHi(0u);
+        r3051->WriteLo(0x80000000u);
+    } else {
+        const auto x = static_cast<int32_t>(s);
+        const auto y = static_cast<int32_t>(t);
+        r3051->WriteHi(static_cast<uint32_t>(x % y));
+        r3051->WriteLo(static_cast<uint32_t>(x / y));
+    }
+}
+
+void InterpretDivu(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    if (t == 0u) {
+        r3051->WriteHi(s);
+        r3051->WriteLo(0xFFFFFFFFu);
+    } else {
+        r3051->WriteHi(s % t);
+        r3051->WriteLo(s / t);
+    }
+}
+
+void InterpretBltz(R3051* r3051, uint32_t opcode) {
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    Branch(r3051, s < 0, BranchTarget(r3051, opcode));
+}
+
+void InterpretBgez(R3051* r3051, uint32_t opcode) {
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    Branch(r3051, s >= 0, BranchTarget(r3051, opcode));
+}
+
+void InterpretBltzal(R3051* r3051, uint32_t opcode) {
+    // The return address is written whether or not the branch is taken
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    WriteRegister(r3051, 31u, ReadPC(r3051) + 8u);
+    Branch(r3051, s < 0, BranchTarget(r3051, opcode));
+}
+
+void InterpretBgezal(R3051* r3051, uint32_t opcode) {
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    WriteRegister(r3051, 31u, ReadPC(r3051) + 8u);
+    Branch(r3051, s >= 0, BranchTarget(r3051, opcode));
+}
+
+void InterpretJ(R3051* r3051, uint32_t opcode) {
+    const uint32_t pc = ReadPC(r3051);
+    Branch(r3051, true, ((pc + 4u) & 0xF0000000u) + (InstructionTarget(opcode) << 2u));
+}
+
+void InterpretJal(R3051* r3051, uint32_t opcode) {
+    const uint32_t pc = ReadPC(r3051);
+    WriteRegister(r3051, 31u, pc + 8u);
+    Branch(r3051, true, ((pc + 4u) & 0xF0000000u) + (InstructionTarget(opcode) << 2u));
+}
+
+void InterpretBeq(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    Branch(r3051, s == t, BranchTarget(r3051, opcode));
+}
+
+void InterpretBne(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    Branch(r3051, s != t, BranchTarget(r3051, opcode));
+}
+
+void InterpretBlez(R3051* r3051, uint32_t opcode) {
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    Branch(r3051, s <= 0, BranchTarget(r3051, opcode));
+}
+
+void InterpretBgtz(R3051* r3051, uint32_t opcode) {
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    Branch(r3051, s > 0, BranchTarget(r3051, opcode));
+}
+
+void InterpretAddi(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t immediate = InstructionImmediateExtended(opcode);
+    const uint32_t result = s + immediate;
+    if (OverflowAdd(s, immediate, result)) {
+        EnterException(r3051, ARITHMETIC_OVERFLOW);
+        return;
+    }
+    WriteRegisterRt(r3051, opcode, result);
+}
+
+void InterpretSlti(R3051* r3051, uint32_t opcode) {
+    const auto s = static_cast<int32_t>(ReadRegisterRs(r3051, opcode));
+    const auto immediate = static_cast<int32_t>(InstructionImmediateExtended(opcode));
+    WriteRegisterRt(r3051, opcode, s < immediate ? 1u : 0u);
+}
+
+void InterpretSltiu(R3051* r3051, uint32_t opcode) {
+    const uint32_t s = ReadRegisterRs(r3051, opcode);
+    const uint32_t immediate = InstructionImmediateExtended(opcode);
+    WriteRegisterRt(r3051, opcode, s < immediate ? 1u : 0u);
+}
+
+void InterpretAndi(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRt(r3051, opcode, ReadRegisterRs(r3051, opcode) & InstructionImmediate(opcode));
+}
+
+void InterpretOri(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRt(r3051, opcode, ReadRegisterRs(r3051, opcode) | InstructionImmediate(opcode));
+}
+
+void InterpretXori(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRt(r3051, opcode, ReadRegisterRs(r3051, opcode) ^ InstructionImmediate(opcode));
+}
+
+void InterpretLui(R3051* r3051, uint32_t opcode) {
+    WriteRegisterRt(r3051, opcode, InstructionImmediate(opcode) << 16u);
+}
+
+void InterpretMfc0(R3051* r3051, uint32_t opcode) {
+    // Coprocessor moves have a load delay slot
+    const uint32_t value = r3051->Cop0().ReadRegister(InstructionRd(opcode));
+    DelayedLoad(r3051, InstructionRt(opcode), value);
+}
+
+void InterpretMtc0(R3051* r3051, uint32_t opcode) {
+    r3051->Cop0().WriteRegister(InstructionRd(opcode), ReadRegisterRt(r3051, opcode));
+    // Unmasking an interrupt that is already pending takes it at the next safe point
+    if (r3051->Cop0().InterruptPending()) {
+        r3051->RequestExit();
+    }
+}
+
+void InterpretCop0Command(R3051* r3051, uint32_t opcode) {
+    // Without a TLB the only command is RFE
+    if (InstructionFunction(opcode) != 0x10u) {
+        InterpretReserved(r3051, opcode);
+        return;
+    }
+    r3051->Cop0().ReturnFromException();
+    if (r3051->Cop0().InterruptPending()) {
+        r3051->RequestExit();
+    }
+}
+
+void InterpretMfc2(R3051* r3051, uint32_t opcode) {
+    const uint32_t value = r3051->Cop2().ReadRegister(InstructionRd(opcode));
+    DelayedLoad(r3051, InstructionRt(opcode), value);
+}
+
+void InterpretCfc2(R3051* r3051, uint32_t opcode) {
+    const uint32_t value = r3051->Cop2().ReadControl(InstructionRd(opcode));
+    DelayedLoad(r3051, InstructionRt(opcode), value);
+}
+
+void InterpretMtc2(R3051* r3051, uint32_t opcode) {
+    r3051->Cop2().WriteRegister(InstructionRd(opcode), ReadRegisterRt(r3051, opcode));
+}
+
+void InterpretCtc2(R3051* r3051, uint32_t opcode) {
+    r3051->Cop2().WriteControl(InstructionRd(opcode), ReadRegisterRt(r3051, opcode));
+}
+
+void InterpretCop2Command(R3051* r3051, uint32_t opcode) {
+    GteCommandAt(InstructionFunction(opcode))(&r3051->Cop2(), opcode);
+}
+
+void InterpretLb(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    uint32_t value;
+    if (LoadByte(r3051, address, &value)) {
+        DelayedLoad(r3051, InstructionRt(opcode), (value ^ 0x80u) - 0x80u);
+    }
+}
+
+void InterpretLh(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    uint32_t value;
+    if (LoadHalf(r3051, address, &value)) {
+        DelayedLoad(r3051, InstructionRt(opcode), (value ^ 0x8000u) - 0x8000u);
+    }
+}
+
+void InterpretLwl(R3051* r3051, uint32_t opcode) {
+    // Merge the most significant bytes of an unaligned word into rt
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    const uint32_t rt = InstructionRt(opcode);
+    const uint32_t t = ReadRegisterBypassed(r3051, rt);
+    uint32_t word;
+    if (LoadWord(r3051, address & ~3u, &word)) {
+        const uint32_t shift = 24u - 8u * (address & 3u);
+        const uint32_t mask = 0x00FFFFFFu >> (8u * (address & 3u));
+        DelayedLoad(r3051, rt, (t & mask) | (word << shift));
+    }
+}
+
+void InterpretLbu(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    uint32_t value;
+    if (LoadByte(r3051, address, &value)) {
+        DelayedLoad(r3051, InstructionRt(opcode), value);
+    }
+}
+
+void InterpretLhu(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    uint32_t value;
+    if (LoadHalf(r3051, address, &value)) {
+        DelayedLoad(r3051, InstructionRt(opcode), value);
+    }
+}
+
+void InterpretLwr(R3051* r3051, uint32_t opcode) {
+    // Merge the least significant bytes of an unaligned word into rt
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    const uint32_t rt = InstructionRt(opcode);
+    const uint32_t t = ReadRegisterBypassed(r3051, rt);
+    uint32_t word;
+    if (LoadWord(r3051, address & ~3u, &word)) {
+        const uint32_t shift = 8u * (address & 3u);
+        const uint32_t mask = ~(0xFFFFFFFFu >> shift);
+        DelayedLoad(r3051, rt, (t & mask) | (word >> shift));
+    }
+}
+
+void InterpretSb(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    StoreByte(r3051, address, ReadRegisterRt(r3051, opcode));
+}
+
+void InterpretSh(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    StoreHalf(r3051, address, ReadRegisterRt(r3051, opcode));
+}
+
+void InterpretSwl(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    uint32_t word;
+    if (LoadWord(r3051, address & ~3u, &word)) {
+        const uint32_t shift = 24u - 8u * (address & 3u);
+        const uint32_t mask = ~(0xFFFFFFFFu >> shift);
+        StoreWord(r3051, address & ~3u, (word & mask) | (t >> shift));
+    }
+}
+
+void InterpretSwr(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    const uint32_t t = ReadRegisterRt(r3051, opcode);
+    uint32_t word;
+    if (LoadWord(r3051, address & ~3u, &word)) {
+        const uint32_t shift = 8u * (address & 3u);
+        const uint32_t mask = 0x00FFFFFFu >> (24u - shift);
+        StoreWord(r3051, address & ~3u, (word & mask) | (t << shift));
+    }
+}
+
+void InterpretLwc2(R3051* r3051, uint32_t opcode) {
+    // Loads straight into a GTE data register without a delay slot
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    uint32_t value;
+    if (LoadWord(r3051, address, &value)) {
+        r3051->Cop2().WriteRegister(InstructionRt(opcode), value);
+    }
+}
+
+void InterpretSwc2(R3051* r3051, uint32_t opcode) {
+    const uint32_t address = ReadRegisterRs(r3051, opcode) + InstructionImmediateExtended(opcode);
+    StoreWord(r3051, address, r3051->Cop2().ReadRegister(InstructionRt(opcode)));
+}
+
+void InterpretReserved(R3051* r3051, uint32_t) {
+    EnterException(r3051, RESERVED_INSTRUCTION);
+}
+
+void InterpretCoprocessorUnusable(R3051* r3051, uint32_t) {
+    EnterException(r3051, COPROCESSOR_UNUSABLE);
+}
+
 }
\ No newline at end of file
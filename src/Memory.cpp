@@ -0,0 +1,61 @@
+#include "Memory.h"
+#include "Mmap.h"
+
+#include <cstring>
+
+namespace rbrown {
+
+Memory::Memory(size_t len, bool huge) :
+    ram(nullptr),
+    size(len),
+    mapped(huge ? rbrown::xmmap::HugePageLength(len) : len),
+    pageMode(rbrown::xmmap::PAGES_SMALL) {
+    ram = static_cast<uint8_t*>(huge ? rbrown::xmmap::MapHuge(mapped, pageMode) : rbrown::xmmap::Map(mapped));
+}
+
+Memory::~Memory() {
+    rbrown::xmmap::Unmap(ram, mapped);
+    ram = nullptr;
+    size = 0;
+    mapped = 0;
+}
+
+size_t Memory::Size() const { return size; }
+
+uint32_t Memory::PageMode() const { return pageMode; }
+
+size_t Memory::Physical(uint32_t address) const {
+    // Size is a power of two so RAM repeats throughout the physical address space
+    return (address & 0x1FFFFFFFu) & (size - 1u);
+}
+
+uint32_t Memory::ReadWord(uint32_t address) const {
+    uint32_t value;
+    std::memcpy(&value, ram + Physical(address & ~3u), sizeof(value));
+    return value;
+}
+
+uint32_t Memory::ReadHalf(uint32_t address) const {
+    uint16_t value;
+    std::memcpy(&value, ram + Physical(address & ~1u), sizeof(value));
+    return value;
+}
+
+uint32_t Memory::ReadByte(uint32_t address) const {
+    return ram[Physical(address)];
+}
+
+void Memory::WriteWord(uint32_t address, uint32_t value) {
+    std::memcpy(ram + Physical(address & ~3u), &value, sizeof(value));
+}
+
+void Memory::WriteHalf(uint32_t address, uint32_t value) {
+    const auto half = static_cast<uint16_t>(value);
+    std::memcpy(ram + Physical(address & ~1u), &half, sizeof(half));
+}
+
+void Memory::WriteByte(uint32_t address, uint32_t value) {
+    ram[Physical(address)] = static_cast<uint8_t>(value);
+}
+
+}
@@ -1,17 +1,135 @@
 #include "Mmap.h"
 
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <linux/mman.h>
 #include <sys/mman.h>
 
 namespace rbrown::xmmap {
 
+namespace {
+
+// madvise succeeds even when transparent huge pages are turned off
+bool TransparentHugePagesEnabled() {
+    FILE* file = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!file) {
+        return false;
+    }
+    char setting[64] { };
+    const bool read = std::fgets(setting, sizeof(setting), file) != nullptr;
+    std::fclose(file);
+    return read && !std::strstr(setting, "[never]");
+}
+
+// Candidates either side of the anchor, none so far that a rel32 from the
+// executable can't reach every byte of the mapping
+constexpr uintptr_t NEAR_STEP = 0x4000000u;
+constexpr uintptr_t NEAR_REACH = 0x70000000u;
+
+void* MapAnywhere(size_t length, int flags) {
+    void* addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return addr == MAP_FAILED ? nullptr : addr;
+}
+
+void* MapNearAnchor(size_t length, int flags, uintptr_t anchor) {
+    const uintptr_t base = anchor & ~(NEAR_STEP - 1u);
+    for (uintptr_t distance = NEAR_STEP; distance + length <= NEAR_REACH; distance += NEAR_STEP) {
+        for (const uintptr_t candidate : { base + distance, base - distance }) {
+            // Below zero wraps around to addresses that are never available
+            if (candidate < NEAR_STEP || candidate > UINTPTR_MAX - length) {
+                continue;
+            }
+            auto* hint = reinterpret_cast<void*>(candidate);
+            void* addr = mmap(hint, length, PROT_READ | PROT_WRITE, flags | MAP_FIXED_NOREPLACE, -1, 0);
+            if (addr == hint) {
+                return addr;
+            }
+            // Kernels before 4.17 take the address as a hint and may put the mapping anywhere
+            if (addr != MAP_FAILED) {
+                munmap(addr, length);
+            }
+        }
+    }
+    return nullptr;
+}
+
+void* MapPlaced(size_t length, int flags, uintptr_t anchor) {
+    void* addr = anchor ? MapNearAnchor(length, flags, anchor) : nullptr;
+    return addr ? addr : MapAnywhere(length, flags);
+}
+
+}
+
+uintptr_t ExecutableAddress() {
+    return reinterpret_cast<uintptr_t>(&ExecutableAddress);
+}
+
+void* MapNear(size_t length, uintptr_t anchor) {
+    return MapPlaced(length, MAP_PRIVATE | MAP_ANONYMOUS, anchor);
+}
+
 void* Map(size_t length) {
     return mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 }
 
+void* MapHuge(size_t length, uint32_t& mode, uintptr_t anchor) {
+    void* addr = MapPlaced(length, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, anchor);
+    if (addr) {
+        mode = PAGES_HUGETLB;
+        return addr;
+    }
+    // No pages reserved in the hugetlb pool, so over-allocate by a huge page and
+    // trim both ends to leave a mapping that transparent huge pages can cover
+    mode = PAGES_SMALL;
+    void* raw = MapPlaced(length + HUGE_PAGE_SIZE, MAP_PRIVATE | MAP_ANONYMOUS, anchor);
+    if (!raw) {
+        return nullptr;
+    }
+    const auto start = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1u) & ~(HUGE_PAGE_SIZE - 1u);
+    if (aligned != start) {
+        munmap(raw, aligned - start);
+    }
+    if (aligned + length != start + length + HUGE_PAGE_SIZE) {
+        munmap(reinterpret_cast<void*>(aligned + length), start + HUGE_PAGE_SIZE - aligned);
+    }
+    addr = reinterpret_cast<void*>(aligned);
+    if (TransparentHugePagesEnabled() && madvise(addr, length, MADV_HUGEPAGE) == 0) {
+        mode = PAGES_TRANSPARENT;
+    }
+    return addr;
+}
+
+size_t HugePageLength(size_t length) {
+    return (length + HUGE_PAGE_SIZE - 1u) & ~(HUGE_PAGE_SIZE - 1u);
+}
+
+const char* PageModeName(uint32_t mode) {
+    switch (mode) {
+        case PAGES_HUGETLB:
+            return "hugetlb";
+        case PAGES_TRANSPARENT:
+            return "transparent huge pages";
+        default:
+            return "small pages";
+    }
+}
+
+void* MapFile(int file, size_t length) {
+    void* addr = mmap(nullptr, length, PROT_READ | PROT_EXEC, MAP_PRIVATE, file, 0);
+    return addr == MAP_FAILED ? nullptr : addr;
+}
+
 int Protect(void* addr, size_t length) {
     return mprotect(addr, length, PROT_READ | PROT_EXEC);
 }
 
+int ProtectWriteExecute(void* addr, size_t length) {
+    return mprotect(addr, length, PROT_READ | PROT_WRITE | PROT_EXEC);
+}
+
 int Unmap(void* addr, size_t length) {
     return munmap(addr, length);
 }
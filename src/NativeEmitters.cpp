@@ -0,0 +1,416 @@
+#include "NativeEmitters.h"
+#include "BlockAbi.h"
+#include "Decoder.h"
+#include "EmitterX64.h"
+#include "HelperTable.h"
+#include "RecomilerState.h"
+#include "MIPS.h"
+
+namespace rbrown {
+
+namespace {
+
+using Operation = void (EmitterX64::*)(uint32_t, uint32_t);
+using ImmediateOperation = void (EmitterX64::*)(uint32_t, uint32_t);
+using ShiftOperation = void (EmitterX64::*)(uint32_t, uint8_t);
+using VariableShiftOperation = void (EmitterX64::*)(uint32_t);
+using SetOperation = void (EmitterX64::*)(uint32_t);
+using MultiplyOperation = void (EmitterX64::*)(uint32_t);
+
+void EmitRegister(RecompilerState& state, EmitterX64& emitter, uint32_t opcode, Operation operation) {
+    // Rd = Rs op Rt
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+    (emitter.*operation)(RAX, RCX);
+    EmitStoreRegister(state, emitter, InstructionRd(opcode), RAX);
+}
+
+void EmitImmediate(RecompilerState& state, EmitterX64& emitter, uint32_t opcode, uint32_t immediate, ImmediateOperation operation) {
+    // Rt = Rs op Immediate
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    (emitter.*operation)(RAX, immediate);
+    EmitStoreRegister(state, emitter, InstructionRt(opcode), RAX);
+}
+
+void EmitShift(RecompilerState& state, EmitterX64& emitter, uint32_t opcode, ShiftOperation operation) {
+    // Rd = Rt shift Sa
+    EmitLoadRegister(state, emitter, RAX, InstructionRt(opcode));
+    (emitter.*operation)(RAX, static_cast<uint8_t>(InstructionShift(opcode)));
+    EmitStoreRegister(state, emitter, InstructionRd(opcode), RAX);
+}
+
+void EmitVariableShift(RecompilerState& state, EmitterX64& emitter, uint32_t opcode, VariableShiftOperation operation) {
+    // Rd = Rt shift Rs, x64 masks the count in CL to five bits just like MIPS
+    EmitLoadRegister(state, emitter, RCX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RAX, InstructionRt(opcode));
+    (emitter.*operation)(RAX);
+    EmitStoreRegister(state, emitter, InstructionRd(opcode), RAX);
+}
+
+void EmitSetRegister(RecompilerState& state, EmitterX64& emitter, uint32_t opcode, SetOperation operation) {
+    // Rd = Rs < Rt
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+    emitter.CmpR32R32(RAX, RCX);
+    (emitter.*operation)(RAX);
+    emitter.MovzxR32R8(RAX, RAX);
+    EmitStoreRegister(state, emitter, InstructionRd(opcode), RAX);
+}
+
+void EmitSetImmediate(RecompilerState& state, EmitterX64& emitter, uint32_t opcode, SetOperation operation) {
+    // Rt = Rs < Immediate
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    emitter.CmpR32Imm32(RAX, InstructionImmediateExtended(opcode));
+    (emitter.*operation)(RAX);
+    emitter.MovzxR32R8(RAX, RAX);
+    EmitStoreRegister(state, emitter, InstructionRt(opcode), RAX);
+}
+
+void EmitTrapOnOverflow(RecompilerState& state, EmitterX64& emitter, uint32_t rd) {
+    // The result is in RAX, only write it back if the operation didn't overflow
+    Label setRegister = emitter.NewLabel();
+    emitter.Jno(setRegister);
+    EmitRaiseException(state, emitter, ARITHMETIC_OVERFLOW);
+    emitter.Bind(setRegister);
+    EmitStoreRegister(state, emitter, rd, RAX);
+}
+
+void EmitCacheHiLo(RecompilerState& state, EmitterX64& emitter) {
+    // MTHI and MTLO only replace one half so the other must be loaded first
+    if (!state.GetHiLoCached()) {
+        emitter.MovR32Disp32(HOST_HI, CONTEXT, static_cast<uint32_t>(R3051::HiOffset()));
+        emitter.MovR32Disp32(HOST_LO, CONTEXT, static_cast<uint32_t>(R3051::LoOffset()));
+        state.SetHiLoCached(true);
+    }
+}
+
+void EmitMoveFrom(RecompilerState& state, EmitterX64& emitter, uint32_t opcode, uint32_t host, size_t offset) {
+    // Rd = HI or LO, read from the processor if a multiply or divide hasn't left it in a register
+    if (state.GetHiLoCached()) {
+        EmitStoreRegister(state, emitter, InstructionRd(opcode), host);
+    } else {
+        emitter.MovR32Disp32(RAX, CONTEXT, static_cast<uint32_t>(offset));
+        EmitStoreRegister(state, emitter, InstructionRd(opcode), RAX);
+    }
+}
+
+void EmitMultiply(RecompilerState& state, EmitterX64& emitter, uint32_t opcode, MultiplyOperation operation) {
+    // EDX:EAX = Rs * Rt
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+    (emitter.*operation)(RCX);
+    emitter.MovR32R32(HOST_LO, RAX);
+    emitter.MovR32R32(HOST_HI, RDX);
+    state.SetHiLoCached(true);
+}
+
+void EmitExceptionExit(RecompilerState& state, EmitterX64& emitter) {
+    EmitFlushHiLo(state, emitter);
+    // The interpreter still retires a load in its delay slot when an exception is taken
+    if (state.GetLoadDelaySlot()) {
+        emitter.MovR64R64(RDI, CONTEXT);
+        EmitCallHelper(emitter, HELPER_RETIRE_LOAD);
+    }
+    EmitBlockEpilogue(emitter);
+}
+
+}
+
+void EmitRaiseException(RecompilerState& state, EmitterX64& emitter, uint32_t code) {
+    // Restore the PC and delay slot state the exception is taken from and leave the block
+    EmitFlushRegisterCache(state, emitter);
+    EmitStorePC(emitter, state.GetPC());
+    if (state.GetBranchDelaySlot()) {
+        EmitSetBranchDelaySlot(emitter, true);
+    }
+    emitter.MovR64R64(RDI, CONTEXT);
+    emitter.MovR32Imm32(RSI, code);
+    EmitCallHelper(emitter, HELPER_ENTER_EXCEPTION);
+    EmitExceptionExit(state, emitter);
+}
+
+void EmitSetBranchDelaySlot(EmitterX64& emitter, bool slot) {
+    emitter.MovR64R64(RDI, CONTEXT);
+    emitter.MovR32Imm32(RSI, slot ? 1u : 0u);
+    EmitCallHelper(emitter, HELPER_SET_BRANCH_DELAY_SLOT);
+}
+
+void EmitFlushHiLo(RecompilerState& state, EmitterX64& emitter) {
+    // Only writes HI and LO back, the code that follows may still use the cached copies
+    if (state.GetHiLoCached()) {
+        emitter.MovDisp32R32(CONTEXT, static_cast<uint32_t>(R3051::HiOffset()), HOST_HI);
+        emitter.MovDisp32R32(CONTEXT, static_cast<uint32_t>(R3051::LoOffset()), HOST_LO);
+    }
+}
+
+void EmitInterpreterFallback(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    // Call the interpreter function for an instruction without a native implementation
+    // Delay slot state lives in the processor but changed guest registers have to be written back
+    // and every cached one reloaded afterwards as the call clobbers the host registers they are cached in
+    // HI and LO are written back too and read from the processor afterwards in case the function uses them
+    // A delay slot whose branch was resolved natively, as in a cached loop, isn't known to the processor yet
+    // and an exception has to see it to restart at the branch
+    Label resume = emitter.NewLabel();
+    EmitFlushRegisterCache(state, emitter);
+    EmitFlushHiLo(state, emitter);
+    EmitStorePC(emitter, state.GetPC());
+    if (state.GetBranchDelaySlot()) {
+        EmitSetBranchDelaySlot(emitter, true);
+    }
+    emitter.MovR64R64(RDI, CONTEXT);
+    emitter.MovR32Imm32(RSI, opcode);
+    EmitCallHelper(emitter, HELPER_INTERPRET + DecodeIndex(opcode));
+    state.SetHiLoCached(false);
+    // Interpreter functions only write the PC when they take an exception
+    emitter.MovR32Disp32(RAX, CONTEXT, static_cast<uint32_t>(R3051::PCOffset()));
+    emitter.CmpR32Imm32(RAX, state.GetPC());
+    emitter.Je(resume);
+    EmitExceptionExit(state, emitter);
+    emitter.Bind(resume);
+    EmitFillRegisterCache(state, emitter);
+}
+
+void EmitLoadRegister(const RecompilerState& state, EmitterX64& emitter, uint32_t host, uint32_t guest) {
+    // Guest registers cached in host registers are copied instead of loaded
+    const uint32_t cached = state.GetHostRegister(guest);
+    if (cached == NO_HOST_REGISTER) {
+        EmitLoadGuestRegister(emitter, host, guest);
+    } else {
+        emitter.MovR32R32(host, cached);
+    }
+}
+
+void EmitStoreRegister(RecompilerState& state, EmitterX64& emitter, uint32_t guest, uint32_t host) {
+    // $zero is never cached so its writes are still discarded
+    const uint32_t cached = state.GetHostRegister(guest);
+    if (cached == NO_HOST_REGISTER) {
+        EmitStoreGuestRegister(emitter, guest, host);
+    } else {
+        emitter.MovR32R32(cached, host);
+        state.SetHostRegisterDirty(guest, true);
+    }
+}
+
+void EmitFillRegisterCache(RecompilerState& state, EmitterX64& emitter) {
+    // Every cached register matches the processor's copy afterwards
+    for (uint32_t guest = 1u; guest < 32u; ++guest) {
+        const uint32_t host = state.GetHostRegister(guest);
+        if (host != NO_HOST_REGISTER) {
+            EmitLoadGuestRegister(emitter, host, guest);
+            state.SetHostRegisterDirty(guest, false);
+        }
+    }
+}
+
+void EmitFlushRegisterCache(const RecompilerState& state, EmitterX64& emitter) {
+    // Only registers written since they were last loaded or flushed on the way here need
+    // storing, the rest already match the processor's copy. The state isn't changed as
+    // side exits flush too and the code that follows may still use the cached copies
+    for (uint32_t guest = 1u; guest < 32u; ++guest) {
+        const uint32_t host = state.GetHostRegister(guest);
+        if (host != NO_HOST_REGISTER && state.GetHostRegisterDirty(guest)) {
+            EmitStoreGuestRegister(emitter, guest, host);
+        }
+    }
+}
+
+void EmitSll(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitShift(state, emitter, opcode, &EmitterX64::ShlR32Imm8);
+}
+
+void EmitSrl(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitShift(state, emitter, opcode, &EmitterX64::ShrR32Imm8);
+}
+
+void EmitSra(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitShift(state, emitter, opcode, &EmitterX64::SarR32Imm8);
+}
+
+void EmitSllv(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitVariableShift(state, emitter, opcode, &EmitterX64::ShlR32CL);
+}
+
+void EmitSrlv(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitVariableShift(state, emitter, opcode, &EmitterX64::ShrR32CL);
+}
+
+void EmitSrav(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitVariableShift(state, emitter, opcode, &EmitterX64::SarR32CL);
+}
+
+void EmitAdd(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+    emitter.AddR32R32(RAX, RCX);
+    EmitTrapOnOverflow(state, emitter, InstructionRd(opcode));
+}
+
+void EmitAddu(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitRegister(state, emitter, opcode, &EmitterX64::AddR32R32);
+}
+
+void EmitSub(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+    emitter.SubR32R32(RAX, RCX);
+    EmitTrapOnOverflow(state, emitter, InstructionRd(opcode));
+}
+
+void EmitSubu(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitRegister(state, emitter, opcode, &EmitterX64::SubR32R32);
+}
+
+void EmitAnd(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitRegister(state, emitter, opcode, &EmitterX64::AndR32R32);
+}
+
+void EmitOr(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitRegister(state, emitter, opcode, &EmitterX64::OrR32R32);
+}
+
+void EmitXor(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitRegister(state, emitter, opcode, &EmitterX64::XorR32R32);
+}
+
+void EmitNor(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+    emitter.OrR32R32(RAX, RCX);
+    emitter.NotR32(RAX);
+    EmitStoreRegister(state, emitter, InstructionRd(opcode), RAX);
+}
+
+void EmitSlt(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitSetRegister(state, emitter, opcode, &EmitterX64::SetlR8);
+}
+
+void EmitSltu(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitSetRegister(state, emitter, opcode, &EmitterX64::SetbR8);
+}
+
+void EmitMfhi(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitMoveFrom(state, emitter, opcode, HOST_HI, R3051::HiOffset());
+}
+
+void EmitMthi(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitCacheHiLo(state, emitter);
+    EmitLoadRegister(state, emitter, HOST_HI, InstructionRs(opcode));
+}
+
+void EmitMflo(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitMoveFrom(state, emitter, opcode, HOST_LO, R3051::LoOffset());
+}
+
+void EmitMtlo(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitCacheHiLo(state, emitter);
+    EmitLoadRegister(state, emitter, HOST_LO, InstructionRs(opcode));
+}
+
+void EmitMult(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitMultiply(state, emitter, opcode, &EmitterX64::ImulR32);
+}
+
+void EmitMultu(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitMultiply(state, emitter, opcode, &EmitterX64::MulR32);
+}
+
+void EmitDiv(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    // x64 faults where MIPS gives fixed results so both cases are checked first
+    Label notZero = emitter.NewLabel();
+    Label divide = emitter.NewLabel();
+    Label done = emitter.NewLabel();
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+    emitter.CmpR32Imm32(RCX, 0u);
+    emitter.Jne(notZero);
+    // HI = Rs, LO = Rs < 0 ? 1 : -1
+    emitter.MovR32R32(HOST_HI, RAX);
+    emitter.SarR32Imm8(RAX, 31u);
+    emitter.ShlR32Imm8(RAX, 1u);
+    emitter.NotR32(RAX);
+    emitter.MovR32R32(HOST_LO, RAX);
+    emitter.Jmp(done);
+    emitter.Bind(notZero);
+    // HI = 0, LO = Rs for 0x80000000 / -1
+    emitter.CmpR32Imm32(RCX, 0xFFFFFFFFu);
+    emitter.Jne(divide);
+    emitter.CmpR32Imm32(RAX, 0x80000000u);
+    emitter.Jne(divide);
+    emitter.MovR32R32(HOST_LO, RAX);
+    emitter.XorR32R32(HOST_HI, HOST_HI);
+    emitter.Jmp(done);
+    emitter.Bind(divide);
+    emitter.Cdq();
+    emitter.IdivR32(RCX);
+    emitter.MovR32R32(HOST_LO, RAX);
+    emitter.MovR32R32(HOST_HI, RDX);
+    emitter.Bind(done);
+    state.SetHiLoCached(true);
+}
+
+void EmitDivu(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    Label divide = emitter.NewLabel();
+    Label done = emitter.NewLabel();
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+    emitter.CmpR32Imm32(RCX, 0u);
+    emitter.Jne(divide);
+    // HI = Rs, LO = -1
+    emitter.MovR32R32(HOST_HI, RAX);
+    emitter.MovR32Imm32(HOST_LO, 0xFFFFFFFFu);
+    emitter.Jmp(done);
+    emitter.Bind(divide);
+    emitter.XorR32R32(RDX, RDX);
+    emitter.DivR32(RCX);
+    emitter.MovR32R32(HOST_LO, RAX);
+    emitter.MovR32R32(HOST_HI, RDX);
+    emitter.Bind(done);
+    state.SetHiLoCached(true);
+}
+
+void EmitAddi(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    emitter.AddR32Imm32(RAX, InstructionImmediateExtended(opcode));
+    EmitTrapOnOverflow(state, emitter, InstructionRt(opcode));
+}
+
+void EmitAddiu(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitImmediate(state, emitter, opcode, InstructionImmediateExtended(opcode), &EmitterX64::AddR32Imm32);
+}
+
+void EmitSlti(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitSetImmediate(state, emitter, opcode, &EmitterX64::SetlR8);
+}
+
+void EmitSltiu(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitSetImmediate(state, emitter, opcode, &EmitterX64::SetbR8);
+}
+
+void EmitAndi(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitImmediate(state, emitter, opcode, InstructionImmediate(opcode), &EmitterX64::AndR32Imm32);
+}
+
+void EmitOri(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitImmediate(state, emitter, opcode, InstructionImmediate(opcode), &EmitterX64::OrR32Imm32);
+}
+
+void EmitXori(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    EmitImmediate(state, emitter, opcode, InstructionImmediate(opcode), &EmitterX64::XorR32Imm32);
+}
+
+void EmitLui(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    emitter.MovR32Imm32(RAX, InstructionImmediate(opcode) << 16u);
+    EmitStoreRegister(state, emitter, InstructionRt(opcode), RAX);
+}
+
+void EmitCop2Command(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    // GTE commands never fault and only touch the GTE so they are called
+    // directly with the coprocessor as the argument, skipping the interpreter
+    EmitFlushRegisterCache(state, emitter);
+    emitter.LeaR64Disp32(RDI, CONTEXT, static_cast<uint32_t>(R3051::Cop2Offset()));
+    emitter.MovR32Imm32(RSI, opcode);
+    EmitCallHelper(emitter, HELPER_GTE_COMMAND + InstructionFunction(opcode));
+    EmitFillRegisterCache(state, emitter);
+}
+
+}
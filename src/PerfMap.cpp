@@ -0,0 +1,150 @@
+#include "PerfMap.h"
+#include "Mmap.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace rbrown {
+
+namespace {
+
+// Layouts from tools/perf/util/jitdump.h in the kernel tree
+constexpr uint32_t JITDUMP_MAGIC = 0x4A695444u;
+constexpr uint32_t JITDUMP_VERSION = 1u;
+constexpr uint32_t EM_X86_64 = 62u;
+constexpr uint32_t JIT_CODE_LOAD = 0u;
+
+struct JitDumpHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t totalSize;
+    uint32_t elfMachine;
+    uint32_t pad;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+};
+
+struct JitCodeLoad {
+    uint32_t id;
+    uint32_t totalSize;
+    uint64_t timestamp;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t codeAddress;
+    uint64_t codeSize;
+    uint64_t codeIndex;
+};
+
+constexpr size_t MAX_NAME = 32u;
+constexpr size_t MAX_PATH = 64u;
+
+// perf record -k 1 timestamps its samples with the same clock
+uint64_t Timestamp() {
+    timespec now { };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000u + static_cast<uint64_t>(now.tv_nsec);
+}
+
+void WriteAll(int file, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0u) {
+        const ssize_t written = write(file, bytes, size);
+        if (written <= 0) {
+            return;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+}
+
+PerfMap::PerfMap(bool jitdump) :
+    mapFile { -1 },
+    dumpFile { -1 },
+    marker { nullptr },
+    codeIndex { 0u } {
+    char path[MAX_PATH];
+    std::snprintf(path, sizeof(path), "/tmp/perf-%d.map", static_cast<int>(getpid()));
+    mapFile = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (jitdump) {
+        std::snprintf(path, sizeof(path), "/tmp/jit-%d.dump", static_cast<int>(getpid()));
+        dumpFile = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (dumpFile >= 0) {
+            WriteJitDumpHeader();
+        }
+    }
+}
+
+PerfMap::~PerfMap() {
+    if (marker) {
+        xmmap::Unmap(marker, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    }
+    if (dumpFile >= 0) {
+        close(dumpFile);
+    }
+    if (mapFile >= 0) {
+        close(mapFile);
+    }
+}
+
+void PerfMap::RecordBlock(uint32_t pc, uintptr_t code, size_t size) {
+    char name[MAX_NAME];
+    std::snprintf(name, sizeof(name), "mips_blk_%08x", pc);
+    Record(name, code, size);
+}
+
+void PerfMap::RecordTrace(uint32_t pc, uintptr_t code, size_t size) {
+    char name[MAX_NAME];
+    std::snprintf(name, sizeof(name), "mips_trace_%08x", pc);
+    Record(name, code, size);
+}
+
+void PerfMap::Record(const char* name, uintptr_t code, size_t size) {
+    if (mapFile >= 0) {
+        char line[MAX_PATH];
+        const int length = std::snprintf(line, sizeof(line), "%lx %zx %s\n", static_cast<unsigned long>(code), size, name);
+        WriteAll(mapFile, line, static_cast<size_t>(length));
+    }
+    if (dumpFile >= 0) {
+        const size_t nameSize = std::strlen(name) + 1u;
+        const JitCodeLoad load {
+            JIT_CODE_LOAD,
+            static_cast<uint32_t>(sizeof(JitCodeLoad) + nameSize + size),
+            Timestamp(),
+            static_cast<uint32_t>(getpid()),
+            static_cast<uint32_t>(syscall(SYS_gettid)),
+            code,
+            code,
+            size,
+            codeIndex++
+        };
+        WriteAll(dumpFile, &load, sizeof(load));
+        WriteAll(dumpFile, name, nameSize);
+        WriteAll(dumpFile, reinterpret_cast<const void*>(code), size);
+    }
+}
+
+void PerfMap::WriteJitDumpHeader() {
+    const JitDumpHeader header {
+        JITDUMP_MAGIC,
+        JITDUMP_VERSION,
+        sizeof(JitDumpHeader),
+        EM_X86_64,
+        0u,
+        static_cast<uint32_t>(getpid()),
+        Timestamp(),
+        0u
+    };
+    WriteAll(dumpFile, &header, sizeof(header));
+    // perf record only notices the dump if the file is mapped executable
+    marker = xmmap::MapFile(dumpFile, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+}
+
+}
@@ -0,0 +1,478 @@
+#include "PredecodedInterpreter.h"
+#include "Interpreter.h"
+#include "Memory.h"
+#include "MIPS.h"
+
+namespace rbrown {
+
+namespace {
+
+// Anything without a handler of its own, and the rare cases of those with one
+// such as overflow or a misaligned address, runs through the decoder's interpreter function
+constexpr uint8_t HANDLER_GENERIC = 0u;
+constexpr uint8_t HANDLER_NOP = 1u;
+constexpr uint8_t HANDLER_SLL = 2u;
+constexpr uint8_t HANDLER_JR = 3u;
+constexpr uint8_t HANDLER_ADD = 4u;
+constexpr uint8_t HANDLER_ADDU = 5u;
+constexpr uint8_t HANDLER_SUBU = 6u;
+constexpr uint8_t HANDLER_J = 7u;
+constexpr uint8_t HANDLER_JAL = 8u;
+constexpr uint8_t HANDLER_BEQ = 9u;
+constexpr uint8_t HANDLER_BNE = 10u;
+constexpr uint8_t HANDLER_ADDIU = 11u;
+constexpr uint8_t HANDLER_ORI = 12u;
+constexpr uint8_t HANDLER_LUI = 13u;
+constexpr uint8_t HANDLER_LW = 14u;
+constexpr uint8_t HANDLER_SW = 15u;
+constexpr uint8_t HANDLER_SRL = 16u;
+constexpr uint8_t HANDLER_SRA = 17u;
+constexpr uint8_t HANDLER_SLLV = 18u;
+constexpr uint8_t HANDLER_SRLV = 19u;
+constexpr uint8_t HANDLER_SRAV = 20u;
+constexpr uint8_t HANDLER_JALR = 21u;
+constexpr uint8_t HANDLER_SUB = 22u;
+constexpr uint8_t HANDLER_AND = 23u;
+constexpr uint8_t HANDLER_OR = 24u;
+constexpr uint8_t HANDLER_XOR = 25u;
+constexpr uint8_t HANDLER_NOR = 26u;
+constexpr uint8_t HANDLER_SLT = 27u;
+constexpr uint8_t HANDLER_SLTU = 28u;
+constexpr uint8_t HANDLER_BLTZ = 29u;
+constexpr uint8_t HANDLER_BGEZ = 30u;
+constexpr uint8_t HANDLER_BLEZ = 31u;
+constexpr uint8_t HANDLER_BGTZ = 32u;
+constexpr uint8_t HANDLER_ADDI = 33u;
+constexpr uint8_t HANDLER_SLTI = 34u;
+constexpr uint8_t HANDLER_SLTIU = 35u;
+constexpr uint8_t HANDLER_ANDI = 36u;
+constexpr uint8_t HANDLER_XORI = 37u;
+constexpr uint8_t HANDLER_LB = 38u;
+constexpr uint8_t HANDLER_LH = 39u;
+constexpr uint8_t HANDLER_LBU = 40u;
+constexpr uint8_t HANDLER_LHU = 41u;
+constexpr uint8_t HANDLER_SB = 42u;
+constexpr uint8_t HANDLER_SH = 43u;
+
+constexpr uint32_t PAGE_MASK = DECODED_PAGE_SIZE - 1u;
+constexpr uint32_t SEGMENT_MASK = 0x1FFFFFFFu;
+
+uint32_t PageKey(const Memory* memory, uint32_t address) {
+    // Records only depend on the opcode so pages are keyed by where they sit in RAM,
+    // a write through any segment or mirror then finds the page decoded from it
+    uint32_t physical = address & SEGMENT_MASK;
+    if (memory) {
+        physical &= static_cast<uint32_t>(memory->Size() - 1u);
+    }
+    return physical & ~PAGE_MASK;
+}
+
+DecodedInstruction Record(uint8_t handler, uint32_t opcode, uint32_t immediate) {
+    return DecodedInstruction {
+        handler,
+        static_cast<uint8_t>(InstructionRs(opcode)),
+        static_cast<uint8_t>(InstructionRt(opcode)),
+        static_cast<uint8_t>(InstructionRd(opcode)),
+        immediate
+    };
+}
+
+DecodedInstruction DecodeSpecial(uint32_t opcode) {
+    // Instructions that can't trap and write $zero are decoded as NOPs
+    const bool discard = InstructionRd(opcode) == 0u;
+    const uint32_t shift = InstructionShift(opcode);
+    switch (InstructionFunction(opcode)) {
+        case 0x00: return Record(discard ? HANDLER_NOP : HANDLER_SLL, opcode, shift);
+        case 0x02: return Record(discard ? HANDLER_NOP : HANDLER_SRL, opcode, shift);
+        case 0x03: return Record(discard ? HANDLER_NOP : HANDLER_SRA, opcode, shift);
+        case 0x04: return Record(discard ? HANDLER_NOP : HANDLER_SLLV, opcode, 0u);
+        case 0x06: return Record(discard ? HANDLER_NOP : HANDLER_SRLV, opcode, 0u);
+        case 0x07: return Record(discard ? HANDLER_NOP : HANDLER_SRAV, opcode, 0u);
+        case 0x08: return Record(HANDLER_JR, opcode, 0u);
+        case 0x09: return Record(HANDLER_JALR, opcode, 0u);
+        case 0x20: return Record(HANDLER_ADD, opcode, 0u);
+        case 0x21: return Record(discard ? HANDLER_NOP : HANDLER_ADDU, opcode, 0u);
+        case 0x22: return Record(HANDLER_SUB, opcode, 0u);
+        case 0x23: return Record(discard ? HANDLER_NOP : HANDLER_SUBU, opcode, 0u);
+        case 0x24: return Record(discard ? HANDLER_NOP : HANDLER_AND, opcode, 0u);
+        case 0x25: return Record(discard ? HANDLER_NOP : HANDLER_OR, opcode, 0u);
+        case 0x26: return Record(discard ? HANDLER_NOP : HANDLER_XOR, opcode, 0u);
+        case 0x27: return Record(discard ? HANDLER_NOP : HANDLER_NOR, opcode, 0u);
+        case 0x2A: return Record(discard ? HANDLER_NOP : HANDLER_SLT, opcode, 0u);
+        case 0x2B: return Record(discard ? HANDLER_NOP : HANDLER_SLTU, opcode, 0u);
+        default: return Record(HANDLER_GENERIC, opcode, 0u);
+    }
+}
+
+DecodedInstruction DecodeRegimm(uint32_t opcode) {
+    // The linking forms always write $31 so they're left to the generic handler
+    const uint32_t offset = InstructionImmediateExtended(opcode) << 2u;
+    switch (InstructionRt(opcode)) {
+        case 0x00: return Record(HANDLER_BLTZ, opcode, offset);
+        case 0x01: return Record(HANDLER_BGEZ, opcode, offset);
+        default: return Record(HANDLER_GENERIC, opcode, 0u);
+    }
+}
+
+}
+
+DecodedInstruction Decode(uint32_t opcode) {
+    const bool discard = InstructionRt(opcode) == 0u;
+    const uint32_t offset = InstructionImmediateExtended(opcode) << 2u;
+    switch (InstructionOp(opcode)) {
+        case 0x00: return DecodeSpecial(opcode);
+        case 0x01: return DecodeRegimm(opcode);
+        case 0x02: return Record(HANDLER_J, opcode, (opcode & 0x03FFFFFFu) << 2u);
+        case 0x03: return Record(HANDLER_JAL, opcode, (opcode & 0x03FFFFFFu) << 2u);
+        case 0x04: return Record(HANDLER_BEQ, opcode, offset);
+        case 0x05: return Record(HANDLER_BNE, opcode, offset);
+        case 0x06: return Record(HANDLER_BLEZ, opcode, offset);
+        case 0x07: return Record(HANDLER_BGTZ, opcode, offset);
+        case 0x08: return Record(HANDLER_ADDI, opcode, InstructionImmediateExtended(opcode));
+        case 0x09: return Record(discard ? HANDLER_NOP : HANDLER_ADDIU, opcode, InstructionImmediateExtended(opcode));
+        case 0x0A: return Record(discard ? HANDLER_NOP : HANDLER_SLTI, opcode, InstructionImmediateExtended(opcode));
+        case 0x0B: return Record(discard ? HANDLER_NOP : HANDLER_SLTIU, opcode, InstructionImmediateExtended(opcode));
+        case 0x0C: return Record(discard ? HANDLER_NOP : HANDLER_ANDI, opcode, InstructionImmediate(opcode));
+        case 0x0D: return Record(discard ? HANDLER_NOP : HANDLER_ORI, opcode, InstructionImmediate(opcode));
+        case 0x0E: return Record(discard ? HANDLER_NOP : HANDLER_XORI, opcode, InstructionImmediate(opcode));
+        case 0x0F: return Record(discard ? HANDLER_NOP : HANDLER_LUI, opcode, InstructionImmediate(opcode) << 16u);
+        case 0x20: return Record(HANDLER_LB, opcode, InstructionImmediateExtended(opcode));
+        case 0x21: return Record(HANDLER_LH, opcode, InstructionImmediateExtended(opcode));
+        case 0x23: return Record(HANDLER_LW, opcode, InstructionImmediateExtended(opcode));
+        case 0x24: return Record(HANDLER_LBU, opcode, InstructionImmediateExtended(opcode));
+        case 0x25: return Record(HANDLER_LHU, opcode, InstructionImmediateExtended(opcode));
+        case 0x28: return Record(HANDLER_SB, opcode, InstructionImmediateExtended(opcode));
+        case 0x29: return Record(HANDLER_SH, opcode, InstructionImmediateExtended(opcode));
+        case 0x2B: return Record(HANDLER_SW, opcode, InstructionImmediateExtended(opcode));
+        default: return Record(HANDLER_GENERIC, opcode, 0u);
+    }
+}
+
+PredecodedInterpreter::PredecodedInterpreter(R3051& p) : processor { p }, pages { } {}
+
+const DecodedPage& PredecodedInterpreter::Page(uint32_t pc) {
+    const Memory* memory = processor.GetMemory();
+    const uint32_t base = pc & ~PAGE_MASK;
+    auto it = pages.find(PageKey(memory, base));
+    if (it == pages.end()) {
+        auto page = std::make_unique<DecodedPage>();
+        for (uint32_t i = 0u; i < DECODED_PAGE_INSTRUCTIONS; ++i) {
+            page->instructions[i] = Decode(memory ? memory->ReadWord(base + 4u * i) : 0u);
+        }
+        it = pages.emplace(PageKey(memory, base), std::move(page)).first;
+    }
+    return *it->second;
+}
+
+void PredecodedInterpreter::Invalidate(uint32_t address, uint32_t length) {
+    // Worked out in 64 bits so a range that reaches the top of the address space doesn't wrap
+    if (length == 0u) {
+        return;
+    }
+    const Memory* memory = processor.GetMemory();
+    const uint64_t last = (uint64_t{ address } + length - 1u) & ~uint64_t{ PAGE_MASK };
+    for (uint64_t base = address & ~PAGE_MASK; base <= last; base += DECODED_PAGE_SIZE) {
+        pages.erase(PageKey(memory, static_cast<uint32_t>(base)));
+    }
+}
+
+uint32_t PredecodedInterpreter::Run(uint32_t count) {
+    // pc is the instruction being executed and next the one after it
+    // Branches set a target that only replaces next once the delay slot has executed
+    // Loads become visible after the following instruction via the pending load
+    static void* const handlers[] = {
+        &&generic, &&nop, &&sll, &&jr, &&add, &&addu, &&subu, &&j,
+        &&jal, &&beq, &&bne, &&addiu, &&ori, &&lui, &&lw, &&sw,
+        &&srl, &&sra, &&sllv, &&srlv, &&srav, &&jalr, &&sub, &&and_,
+        &&or_, &&xor_, &&nor, &&slt, &&sltu, &&bltz, &&bgez, &&blez,
+        &&bgtz, &&addi, &&slti, &&sltiu, &&andi, &&xori, &&lb, &&lh,
+        &&lbu, &&lhu, &&sb, &&sh
+    };
+
+    uint32_t* const registers = reinterpret_cast<uint32_t*>(processor.RegisterAddress(0));
+    uint32_t pc = processor.ReadPC();
+    // The processor may be handed over in a delay slot by whatever ran it last
+    bool branched = processor.GetBranchDelaySlot();
+    uint32_t next = branched ? processor.GetBranchTarget() : pc + 4u;
+    processor.SetBranchDelaySlot(false);
+    processor.SetBranchDelaySlotNext(false);
+    uint32_t target = 0u;
+    uint32_t executed = 0u;
+    bool delaySlot = false;
+    uint32_t loadRegister = processor.GetLoadDelaySlot() ? processor.GetLoadDelayRegister() : 0u;
+    uint32_t loadValue = processor.GetLoadDelayValue();
+    uint32_t loadRegisterNext = 0u;
+    uint32_t loadValueNext = 0u;
+    uint32_t pageBase = ~0u;
+    const DecodedInstruction* page = nullptr;
+    const DecodedInstruction* d;
+
+#define DISPATCH()                                                          \
+    do {                                                                    \
+        if ((pc & ~PAGE_MASK) != pageBase) {                                \
+            pageBase = pc & ~PAGE_MASK;                                     \
+            page = Page(pc).instructions;                                   \
+        }                                                                   \
+        d = page + ((pc & PAGE_MASK) >> 2u);                                \
+        delaySlot = branched;                                               \
+        branched = false;                                                   \
+        goto *handlers[d->handler];                                         \
+    } while (false)
+
+#define NEXT()                                                              \
+    do {                                                                    \
+        registers[loadRegister] = loadValue;                                \
+        registers[0] = 0u;                                                  \
+        loadRegister = loadRegisterNext;                                    \
+        loadValue = loadValueNext;                                          \
+        loadRegisterNext = 0u;                                              \
+        pc = next;                                                          \
+        next = branched ? target : pc + 4u;                                 \
+        if (++executed >= count && !branched) {                             \
+            goto exit;                                                      \
+        }                                                                   \
+        DISPATCH();                                                         \
+    } while (false)
+
+#define BRANCH(taken)                                                       \
+    do {                                                                    \
+        target = (taken) ? pc + 4u + d->immediate : pc + 8u;                \
+        branched = true;                                                    \
+        NEXT();                                                             \
+    } while (false)
+
+#define LOAD(value)                                                         \
+    do {                                                                    \
+        /* A load into the register of the pending load replaces it */      \
+        if (loadRegister == d->rt) {                                        \
+            loadRegister = 0u;                                              \
+        }                                                                   \
+        loadRegisterNext = d->rt;                                           \
+        loadValueNext = (value);                                            \
+        NEXT();                                                             \
+    } while (false)
+
+    DISPATCH();
+
+generic:
+    // Hand the instruction to the decoder's interpreter function with the processor
+    // holding exactly the delay slot state we do, then carry on from whatever it left
+    // This also covers exceptions, which restart at the branch if we're in its delay slot
+    processor.WritePC(pc);
+    processor.SetLoadDelaySlot(loadRegister != 0u);
+    processor.SetLoadDelaySlotNext(false);
+    processor.SetLoadDelayRegister(loadRegister);
+    processor.SetLoadDelayValue(loadValue);
+    processor.SetBranchDelaySlot(delaySlot);
+    processor.SetBranchTarget(next);
+    Step(&processor);
+    registers[0] = 0u;
+    pc = processor.ReadPC();
+    branched = processor.GetBranchDelaySlot();
+    next = branched ? processor.GetBranchTarget() : pc + 4u;
+    processor.SetBranchDelaySlot(false);
+    loadRegister = processor.GetLoadDelaySlot() ? processor.GetLoadDelayRegister() : 0u;
+    loadValue = processor.GetLoadDelayValue();
+    loadRegisterNext = 0u;
+    if (++executed >= count && !branched) {
+        goto exit;
+    }
+    DISPATCH();
+nop:
+    NEXT();
+sll:
+    registers[d->rd] = registers[d->rt] << d->immediate;
+    NEXT();
+srl:
+    registers[d->rd] = registers[d->rt] >> d->immediate;
+    NEXT();
+sra:
+    registers[d->rd] = static_cast<uint32_t>(static_cast<int32_t>(registers[d->rt]) >> d->immediate);
+    NEXT();
+sllv:
+    registers[d->rd] = registers[d->rt] << (registers[d->rs] & 0x1Fu);
+    NEXT();
+srlv:
+    registers[d->rd] = registers[d->rt] >> (registers[d->rs] & 0x1Fu);
+    NEXT();
+srav:
+    registers[d->rd] = static_cast<uint32_t>(static_cast<int32_t>(registers[d->rt]) >> (registers[d->rs] & 0x1Fu));
+    NEXT();
+jr:
+    target = registers[d->rs];
+    branched = true;
+    NEXT();
+jalr:
+    // The target is read before the link in case they're the same register
+    target = registers[d->rs];
+    registers[d->rd] = pc + 8u;
+    branched = true;
+    NEXT();
+add: {
+    const uint32_t s = registers[d->rs];
+    const uint32_t t = registers[d->rt];
+    const uint32_t result = s + t;
+    if ((~(s ^ t) & (s ^ result)) >> 31u) {
+        goto generic;
+    }
+    registers[d->rd] = result;
+    NEXT();
+}
+addu:
+    registers[d->rd] = registers[d->rs] + registers[d->rt];
+    NEXT();
+sub: {
+    const uint32_t s = registers[d->rs];
+    const uint32_t t = registers[d->rt];
+    const uint32_t result = s - t;
+    if (((s ^ t) & (s ^ result)) >> 31u) {
+        goto generic;
+    }
+    registers[d->rd] = result;
+    NEXT();
+}
+subu:
+    registers[d->rd] = registers[d->rs] - registers[d->rt];
+    NEXT();
+and_:
+    registers[d->rd] = registers[d->rs] & registers[d->rt];
+    NEXT();
+or_:
+    registers[d->rd] = registers[d->rs] | registers[d->rt];
+    NEXT();
+xor_:
+    registers[d->rd] = registers[d->rs] ^ registers[d->rt];
+    NEXT();
+nor:
+    registers[d->rd] = ~(registers[d->rs] | registers[d->rt]);
+    NEXT();
+slt:
+    registers[d->rd] = static_cast<int32_t>(registers[d->rs]) < static_cast<int32_t>(registers[d->rt]) ? 1u : 0u;
+    NEXT();
+sltu:
+    registers[d->rd] = registers[d->rs] < registers[d->rt] ? 1u : 0u;
+    NEXT();
+j:
+    target = (pc & 0xF0000000u) + d->immediate;
+    branched = true;
+    NEXT();
+jal:
+    registers[31] = pc + 8u;
+    target = (pc & 0xF0000000u) + d->immediate;
+    branched = true;
+    NEXT();
+beq:
+    BRANCH(registers[d->rs] == registers[d->rt]);
+bne:
+    BRANCH(registers[d->rs] != registers[d->rt]);
+bltz:
+    BRANCH(static_cast<int32_t>(registers[d->rs]) < 0);
+bgez:
+    BRANCH(static_cast<int32_t>(registers[d->rs]) >= 0);
+blez:
+    BRANCH(static_cast<int32_t>(registers[d->rs]) <= 0);
+bgtz:
+    BRANCH(static_cast<int32_t>(registers[d->rs]) > 0);
+addi: {
+    const uint32_t s = registers[d->rs];
+    const uint32_t result = s + d->immediate;
+    if ((~(s ^ d->immediate) & (s ^ result)) >> 31u) {
+        goto generic;
+    }
+    registers[d->rt] = result;
+    NEXT();
+}
+addiu:
+    registers[d->rt] = registers[d->rs] + d->immediate;
+    NEXT();
+slti:
+    registers[d->rt] = static_cast<int32_t>(registers[d->rs]) < static_cast<int32_t>(d->immediate) ? 1u : 0u;
+    NEXT();
+sltiu:
+    registers[d->rt] = registers[d->rs] < d->immediate ? 1u : 0u;
+    NEXT();
+andi:
+    registers[d->rt] = registers[d->rs] & d->immediate;
+    NEXT();
+ori:
+    registers[d->rt] = registers[d->rs] | d->immediate;
+    NEXT();
+xori:
+    registers[d->rt] = registers[d->rs] ^ d->immediate;
+    NEXT();
+lui:
+    registers[d->rt] = d->immediate;
+    NEXT();
+lb: {
+    uint32_t value = 0u;
+    LoadByte(&processor, registers[d->rs] + d->immediate, &value);
+    LOAD((value ^ 0x80u) - 0x80u);
+}
+lbu: {
+    uint32_t value = 0u;
+    LoadByte(&processor, registers[d->rs] + d->immediate, &value);
+    LOAD(value);
+}
+lh: {
+    // Misaligned addresses raise an address error through the generic handler
+    const uint32_t address = registers[d->rs] + d->immediate;
+    if (address & 1u) {
+        goto generic;
+    }
+    uint32_t value = 0u;
+    LoadHalf(&processor, address, &value);
+    LOAD((value ^ 0x8000u) - 0x8000u);
+}
+lhu: {
+    const uint32_t address = registers[d->rs] + d->immediate;
+    if (address & 1u) {
+        goto generic;
+    }
+    uint32_t value = 0u;
+    LoadHalf(&processor, address, &value);
+    LOAD(value);
+}
+lw: {
+    const uint32_t address = registers[d->rs] + d->immediate;
+    if (address & 3u) {
+        goto generic;
+    }
+    uint32_t value = 0u;
+    LoadWord(&processor, address, &value);
+    LOAD(value);
+}
+sb:
+    StoreByte(&processor, registers[d->rs] + d->immediate, registers[d->rt]);
+    NEXT();
+sh: {
+    const uint32_t address = registers[d->rs] + d->immediate;
+    if (address & 1u) {
+        goto generic;
+    }
+    StoreHalf(&processor, address, registers[d->rt]);
+    NEXT();
+}
+sw: {
+    const uint32_t address = registers[d->rs] + d->immediate;
+    if (address & 3u) {
+        goto generic;
+    }
+    StoreWord(&processor, address, registers[d->rt]);
+    NEXT();
+}
+
+#undef LOAD
+#undef BRANCH
+#undef NEXT
+#undef DISPATCH
+
+exit:
+    processor.WritePC(pc);
+    processor.SetLoadDelaySlot(loadRegister != 0u);
+    processor.SetLoadDelaySlotNext(false);
+    processor.SetLoadDelayRegister(loadRegister);
+    processor.SetLoadDelayValue(loadValue);
+    return executed;
+}
+
+}
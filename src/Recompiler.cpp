@@ -0,0 +1,497 @@
+#include "Recompiler.h"
+#include "Bios.h"
+#include "BlockAbi.h"
+#include "Decoder.h"
+#include "EmitterX64.h"
+#include "HelperTable.h"
+#include "Memory.h"
+#include "MIPS.h"
+#include "NativeEmitters.h"
+#include "RecomilerState.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace rbrown {
+
+namespace {
+
+constexpr uint32_t MAX_BLOCK_INSTRUCTIONS = 32u;
+
+// Generous bounds on the host code for one guest instruction, the worst being a fallback
+// that writes back every cache register and HI and LO and has an exception exit, along with
+// the calls that retire loads and branches, and on everything else a block emits around them
+constexpr size_t MAX_INSTRUCTION_SIZE = 192u;
+constexpr size_t MAX_BLOCK_OVERHEAD = 1024u;
+
+static_assert(MAX_BLOCK_INSTRUCTIONS * MAX_INSTRUCTION_SIZE + MAX_BLOCK_OVERHEAD <= MAX_BLOCK_SIZE,
+              "a block must fit in the room the code cache keeps for it");
+
+// Every instruction takes a cycle and loads and stores wait a little
+// longer for memory, close enough to schedule devices against
+constexpr uint32_t INSTRUCTION_CYCLES = 1u;
+constexpr uint32_t MEMORY_ACCESS_CYCLES = 1u;
+
+constexpr uint32_t NO_LOOP = 0xFFFFFFFFu;
+
+// Caller saved host registers that no native emitter uses, guest registers
+// are cached in them across the iterations of a loop
+constexpr std::array<uint32_t, 6> CACHE_REGISTERS = { RSI, RDI, R8, R9, R10, R11 };
+
+struct BlockExtent {
+    uint32_t length;
+    uint32_t cycles;
+    // Index of the instruction a branch at the end of the block goes back to
+    uint32_t loopStart;
+    uint32_t loopCycles;
+    // The loop only polls memory so it can't leave until an event has run
+    bool idle;
+};
+
+uint32_t InstructionCycles(const InstructionInfo& info) {
+    uint32_t cycles = INSTRUCTION_CYCLES;
+    if (info.flags & (IS_LOAD | IS_STORE)) {
+        cycles += MEMORY_ACCESS_CYCLES;
+    }
+    return cycles;
+}
+
+bool BranchTarget(uint32_t pc, uint32_t opcode, uint32_t* target) {
+    // Only branches with a fixed target that don't link can close a loop
+    switch (InstructionOp(opcode)) {
+        case 0x01u:
+            if (InstructionRt(opcode) & 0x10u) {
+                return false;
+            }
+            [[fallthrough]];
+        case 0x04u:
+        case 0x05u:
+        case 0x06u:
+        case 0x07u:
+            *target = pc + 4u + (InstructionImmediateExtended(opcode) << 2u);
+            return true;
+        case 0x02u:
+            *target = ((pc + 4u) & 0xF0000000u) | (InstructionTarget(opcode) << 2u);
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t WrittenRegister(uint32_t opcode, uint32_t flags) {
+    if (flags & WRITES_RD) {
+        return InstructionRd(opcode);
+    }
+    if (flags & WRITES_RT) {
+        return InstructionRt(opcode);
+    }
+    if (flags & WRITES_RA) {
+        return 31u;
+    }
+    return 0u;
+}
+
+bool IsIdleLoop(const Memory& memory, uint32_t start, const BlockExtent& extent) {
+    // Only loads, arithmetic that can't trap and the branch back are allowed and every
+    // register the loop reads must either be left alone by it or be written earlier in
+    // the same iteration, so each iteration repeats the last until memory changes
+    uint32_t written = 0u;
+    for (uint32_t i = extent.loopStart; i < extent.length; ++i) {
+        const uint32_t opcode = memory.ReadWord(start + 4u * i);
+        const InstructionInfo& info = DecodeInstruction(opcode);
+        const bool tail = i == extent.length - 2u;
+        const bool arithmetic = info.emit && (info.flags & (WRITES_RD | WRITES_RT)) && !(info.flags & (CAN_FAULT | IS_BRANCH));
+        const bool allowed = opcode == 0u || (info.flags & IS_LOAD) || (tail && (info.flags & IS_BRANCH)) || arithmetic;
+        if (!allowed) {
+            return false;
+        }
+        written |= 1u << WrittenRegister(opcode, info.flags);
+    }
+    written &= ~1u;
+    uint32_t defined = 0u;
+    uint32_t loaded = 0u;
+    for (uint32_t i = extent.loopStart; i < extent.length; ++i) {
+        const uint32_t opcode = memory.ReadWord(start + 4u * i);
+        const InstructionInfo& info = DecodeInstruction(opcode);
+        uint32_t reads = 0u;
+        if (info.flags & READS_RS) {
+            reads |= 1u << InstructionRs(opcode);
+        }
+        if (info.flags & READS_RT) {
+            reads |= 1u << InstructionRt(opcode);
+        }
+        if (reads & written & ~defined) {
+            return false;
+        }
+        // A load's register only changes after the instruction that follows it
+        defined |= loaded;
+        loaded = 0u;
+        if (info.flags & IS_LOAD) {
+            loaded = 1u << WrittenRegister(opcode, info.flags);
+        } else {
+            defined |= 1u << WrittenRegister(opcode, info.flags);
+        }
+    }
+    // A load in the delay slot would still be in flight when the loop comes round
+    return loaded == 0u;
+}
+
+BlockExtent ScanBlock(const Memory& memory, uint32_t start) {
+    // A block ends after the delay slot of its first branch or at the size limit
+    // as long as that doesn't split a branch from its delay slot
+    BlockExtent extent { 0u, 0u, NO_LOOP, 0u, false };
+    bool delaySlot = false;
+    for (uint32_t pc = start;; pc += 4u) {
+        const InstructionInfo& info = DecodeInstruction(memory.ReadWord(pc));
+        ++extent.length;
+        extent.cycles += InstructionCycles(info);
+        const bool branch = (info.flags & IS_BRANCH) != 0u;
+        if (delaySlot || (extent.length >= MAX_BLOCK_INSTRUCTIONS && !branch)) {
+            break;
+        }
+        delaySlot = branch;
+    }
+    if (!delaySlot) {
+        return extent;
+    }
+    // A branch back into the block makes everything from its target onwards a loop
+    const uint32_t branchPc = start + 4u * (extent.length - 2u);
+    uint32_t target;
+    if (!BranchTarget(branchPc, memory.ReadWord(branchPc), &target) || target < start || target > branchPc) {
+        return extent;
+    }
+    extent.loopStart = (target - start) / 4u;
+    for (uint32_t i = extent.loopStart; i < extent.length; ++i) {
+        extent.loopCycles += InstructionCycles(DecodeInstruction(memory.ReadWord(start + 4u * i)));
+    }
+    extent.idle = IsIdleLoop(memory, start, extent);
+    return extent;
+}
+
+bool CanCacheLoop(const Memory& memory, uint32_t start, const BlockExtent& extent) {
+    // Loads would need their delay slots carried around the back edge and the branch
+    // is compared after its delay slot runs so the delay slot mustn't change its operands
+    for (uint32_t i = extent.loopStart; i < extent.length - 2u; ++i) {
+        const InstructionInfo& info = DecodeInstruction(memory.ReadWord(start + 4u * i));
+        if (info.flags & (IS_LOAD | IS_BRANCH)) {
+            return false;
+        }
+    }
+    const uint32_t branch = memory.ReadWord(start + 4u * (extent.length - 2u));
+    const uint32_t delaySlot = memory.ReadWord(start + 4u * (extent.length - 1u));
+    const InstructionInfo& info = DecodeInstruction(delaySlot);
+    if (info.flags & (IS_LOAD | IS_BRANCH)) {
+        return false;
+    }
+    const uint32_t written = WrittenRegister(delaySlot, info.flags);
+    return written == 0u || (written != InstructionRs(branch) && written != InstructionRt(branch));
+}
+
+bool CachedLoopFits(const BlockExtent& extent) {
+    // The cached copy of the loop is emitted after the whole block so it's
+    // only worth having when both still fit in the room kept for one block
+    const size_t instructions = 2u * extent.length - extent.loopStart;
+    return instructions * MAX_INSTRUCTION_SIZE + MAX_BLOCK_OVERHEAD <= MAX_BLOCK_SIZE;
+}
+
+void AllocateCacheRegisters(RecompilerState& state, const Memory& memory, uint32_t start, const BlockExtent& extent) {
+    // The most used guest registers in the loop get the host registers
+    std::array<uint32_t, 32> uses { };
+    for (uint32_t i = extent.loopStart; i < extent.length; ++i) {
+        const uint32_t opcode = memory.ReadWord(start + 4u * i);
+        const uint32_t flags = DecodeInstruction(opcode).flags;
+        if (flags & READS_RS) {
+            ++uses[InstructionRs(opcode)];
+        }
+        if (flags & READS_RT) {
+            ++uses[InstructionRt(opcode)];
+        }
+        ++uses[WrittenRegister(opcode, flags)];
+    }
+    uses[0] = 0u;
+    for (const uint32_t host : CACHE_REGISTERS) {
+        const auto guest = static_cast<uint32_t>(std::max_element(uses.begin(), uses.end()) - uses.begin());
+        if (uses[guest] == 0u) {
+            return;
+        }
+        state.SetHostRegister(guest, host);
+        uses[guest] = 0u;
+    }
+}
+
+void EmitRetireLoad(EmitterX64& emitter) {
+    emitter.MovR64R64(RDI, CONTEXT);
+    EmitCallHelper(emitter, HELPER_RETIRE_LOAD);
+}
+
+void EmitRetireBranch(EmitterX64& emitter, uint32_t pc) {
+    emitter.MovR64R64(RDI, CONTEXT);
+    emitter.MovR32Imm32(RSI, pc);
+    EmitCallHelper(emitter, HELPER_RETIRE_BRANCH);
+}
+
+void EmitChargeCycles(EmitterX64& emitter, uint32_t cycles) {
+    emitter.SubDisp32Imm32(CONTEXT, static_cast<uint32_t>(R3051::DowncountOffset()), cycles);
+}
+
+void EmitBiosCall(EmitterX64& emitter, uint32_t vector) {
+    // Functions with a native implementation return straight to the caller and
+    // the rest carry on into the guest's own BIOS code
+    Label guest = emitter.NewLabel();
+    emitter.MovR64R64(RDI, CONTEXT);
+    emitter.MovR32Imm32(RSI, vector);
+    EmitCallHelper(emitter, HELPER_CALL_BIOS);
+    emitter.MovR32Disp32(RAX, CONTEXT, static_cast<uint32_t>(R3051::PCOffset()));
+    emitter.CmpR32Imm32(RAX, vector);
+    emitter.Je(guest);
+    EmitBlockEpilogue(emitter);
+    emitter.Bind(guest);
+}
+
+void EmitInstruction(RecompilerState& state, EmitterX64& emitter, uint32_t opcode) {
+    const InstructionInfo& info = DecodeInstruction(opcode);
+    if (info.emit) {
+        info.emit(state, emitter, opcode);
+    } else {
+        EmitInterpreterFallback(state, emitter, opcode);
+    }
+}
+
+void EmitLoopCheck(EmitterX64& emitter, Label& leave) {
+    // Leave the loop once its cycles are used up or something asks the processor to stop
+    emitter.CmpDisp32Imm8(CONTEXT, static_cast<uint32_t>(R3051::DowncountOffset()), 0u);
+    emitter.Jle(leave);
+    emitter.CmpDisp32Imm8(CONTEXT, static_cast<uint32_t>(R3051::ExitRequestOffset()), 0u);
+    emitter.Jne(leave);
+}
+
+void EmitBranchTaken(const RecompilerState& state, EmitterX64& emitter, uint32_t opcode, Label& taken) {
+    // Rs compared with Rt or zero
+    EmitLoadRegister(state, emitter, RAX, InstructionRs(opcode));
+    switch (InstructionOp(opcode)) {
+        case 0x01u:
+            emitter.CmpR32Imm8(RAX, 0u);
+            if (InstructionRt(opcode) & 1u) {
+                emitter.Jge(taken);
+            } else {
+                emitter.Jl(taken);
+            }
+            break;
+        case 0x02u:
+            emitter.Jmp(taken);
+            break;
+        case 0x04u:
+        case 0x05u:
+            EmitLoadRegister(state, emitter, RCX, InstructionRt(opcode));
+            emitter.CmpR32R32(RAX, RCX);
+            if (InstructionOp(opcode) == 0x04u) {
+                emitter.Je(taken);
+            } else {
+                emitter.Jne(taken);
+            }
+            break;
+        case 0x06u:
+            emitter.CmpR32Imm8(RAX, 0u);
+            emitter.Jle(taken);
+            break;
+        default:
+            emitter.CmpR32Imm8(RAX, 0u);
+            emitter.Jg(taken);
+            break;
+    }
+}
+
+bool EmitBlockBody(RecompilerState& state, EmitterX64& emitter, const Memory& memory, const BlockExtent& extent, Label& loop) {
+    // Returns whether the block ended with a branch and its delay slot
+    for (uint32_t i = 0u; i < extent.length; ++i) {
+        if (i == extent.loopStart) {
+            // Reached from both the code before it and the back edge so assume the worst of each
+            EmitFlushHiLo(state, emitter);
+            state.SetHiLoCached(false);
+            state.SetLoadDelaySlot(true);
+            emitter.Bind(loop);
+        }
+        const uint32_t pc = state.GetPC();
+        const uint32_t opcode = memory.ReadWord(pc);
+        const InstructionInfo& info = DecodeInstruction(opcode);
+        EmitInstruction(state, emitter, opcode);
+        // Loads only need bookkeeping while one might be in flight
+        state.SetLoadDelaySlotNext((info.flags & IS_LOAD) != 0u);
+        if (state.GetLoadDelaySlot() || state.GetLoadDelaySlotNext()) {
+            EmitRetireLoad(emitter);
+        }
+        state.SetLoadDelaySlot(state.GetLoadDelaySlotNext());
+        state.SetLoadDelaySlotNext(false);
+        // The branch target is only known once the branch has executed
+        const bool delaySlot = state.GetBranchDelaySlot();
+        const bool branch = (info.flags & IS_BRANCH) != 0u;
+        if (branch || delaySlot) {
+            EmitRetireBranch(emitter, pc);
+        }
+        state.SetBranchDelaySlot(branch && !delaySlot);
+        state.SetPC(pc + 4u);
+        if (delaySlot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void EmitCachedLoop(EmitterX64& emitter, const Memory& memory, uint32_t start, const BlockExtent& extent) {
+    // Later iterations keep guest registers in host registers and only
+    // write them back when the loop is left
+    const uint32_t target = start + 4u * extent.loopStart;
+    const uint32_t branchPc = start + 4u * (extent.length - 2u);
+    const uint32_t branch = memory.ReadWord(branchPc);
+    RecompilerState state(target);
+    AllocateCacheRegisters(state, memory, start, extent);
+    EmitFillRegisterCache(state, emitter);
+    // The back edge arrives at the top with whatever the previous iteration wrote still
+    // only in host registers, so anything the loop writes starts out dirty
+    for (uint32_t pc = target; pc <= branchPc + 4u; pc += 4u) {
+        const uint32_t opcode = memory.ReadWord(pc);
+        const uint32_t written = WrittenRegister(opcode, DecodeInstruction(opcode).flags);
+        if (state.GetHostRegister(written) != NO_HOST_REGISTER) {
+            state.SetHostRegisterDirty(written, true);
+        }
+    }
+    Label top = emitter.NewLabel();
+    Label taken = emitter.NewLabel();
+    Label leave = emitter.NewLabel();
+    emitter.Bind(top);
+    for (uint32_t pc = target; pc < branchPc; pc += 4u) {
+        state.SetPC(pc);
+        EmitInstruction(state, emitter, memory.ReadWord(pc));
+    }
+    // The branch is compared after its delay slot which can't change the operands
+    state.SetPC(branchPc + 4u);
+    state.SetBranchDelaySlot(true);
+    const uint32_t delaySlot = memory.ReadWord(branchPc + 4u);
+    EmitInstruction(state, emitter, delaySlot);
+    // A fallback marks the processor as being in the delay slot and nothing here retires the branch
+    // The helper call clobbers the cached registers again but they match the processor's copies
+    if (!DecodeInstruction(delaySlot).emit) {
+        EmitSetBranchDelaySlot(emitter, false);
+        EmitFillRegisterCache(state, emitter);
+    }
+    EmitBranchTaken(state, emitter, branch, taken);
+    EmitFlushRegisterCache(state, emitter);
+    EmitFlushHiLo(state, emitter);
+    EmitStorePC(emitter, branchPc + 8u);
+    EmitBlockEpilogue(emitter);
+    emitter.Bind(taken);
+    EmitLoopCheck(emitter, leave);
+    EmitChargeCycles(emitter, extent.loopCycles);
+    // The top of the loop expects HI and LO in the processor
+    EmitFlushHiLo(state, emitter);
+    emitter.Jmp32(top);
+    emitter.Bind(leave);
+    EmitFlushRegisterCache(state, emitter);
+    EmitFlushHiLo(state, emitter);
+    EmitStorePC(emitter, target);
+}
+
+}
+
+uint32_t Recompile(EmitterX64& emitter, const Memory& memory, uint32_t start) {
+    // The whole cost of the block is known before it runs so it is charged once on entry
+    const BlockExtent extent = ScanBlock(memory, start);
+    const bool cached = extent.loopStart != NO_LOOP && !extent.idle && CanCacheLoop(memory, start, extent) && CachedLoopFits(extent);
+    RecompilerState state(start);
+    // The block may be entered with a load from the previous one still in its delay slot
+    state.SetLoadDelaySlot(true);
+    EmitBlockPrologue(emitter);
+    EmitChargeCycles(emitter, extent.cycles);
+    if (IsBiosVector(start)) {
+        EmitBiosCall(emitter, start);
+    }
+    Label loop = emitter.NewLabel();
+    const bool branched = EmitBlockBody(state, emitter, memory, extent, loop);
+    // A block cut short by the size limit carries on at the next instruction
+    if (!branched) {
+        EmitStorePC(emitter, state.GetPC());
+    }
+    EmitFlushHiLo(state, emitter);
+    if (extent.loopStart != NO_LOOP) {
+        // The first iteration runs above where a load from the previous block may
+        // still be in flight, the back edge either loops to it or to a cached copy
+        Label iterate = emitter.NewLabel();
+        Label leave = emitter.NewLabel();
+        emitter.MovR32Disp32(RAX, CONTEXT, static_cast<uint32_t>(R3051::PCOffset()));
+        emitter.CmpR32Imm32(RAX, start + 4u * extent.loopStart);
+        emitter.Jne(leave);
+        if (extent.idle) {
+            // Nothing the loop reads can change until an event runs so
+            // use up the rest of the slice and skip straight to it
+            emitter.CmpDisp32Imm8(CONTEXT, static_cast<uint32_t>(R3051::DowncountOffset()), 0u);
+            emitter.Jle(leave);
+            emitter.MovDisp32Imm32(CONTEXT, static_cast<uint32_t>(R3051::DowncountOffset()), 0u);
+            emitter.Bind(leave);
+            EmitBlockEpilogue(emitter);
+            return extent.length;
+        }
+        EmitLoopCheck(emitter, leave);
+        emitter.Jmp(iterate);
+        emitter.Bind(leave);
+        EmitBlockEpilogue(emitter);
+        emitter.Bind(iterate);
+        EmitChargeCycles(emitter, extent.loopCycles);
+        if (cached) {
+            EmitCachedLoop(emitter, memory, start, extent);
+        } else {
+            emitter.Jmp32(loop);
+            return extent.length;
+        }
+    }
+    EmitBlockEpilogue(emitter);
+    return extent.length;
+}
+
+std::vector<TraceBlock> RecompileTrace(EmitterX64& emitter, const Memory& memory, const std::vector<uint32_t>& path) {
+    // Blocks with a loop of their own or at a BIOS vector are left to Recompile so the trace stops before one
+    std::vector<TraceBlock> blocks;
+    std::vector<BlockExtent> extents;
+    for (const uint32_t pc : path) {
+        const BlockExtent extent = ScanBlock(memory, pc);
+        if (extent.loopStart != NO_LOOP || IsBiosVector(pc)) {
+            break;
+        }
+        blocks.push_back({ pc, extent.length });
+        extents.push_back(extent);
+    }
+    if (blocks.size() < 2u) {
+        return { };
+    }
+    // Load delay and HI and LO caching carry on from one block into the next
+    // Exits and interrupts are only looked at by the dispatcher once the trace returns
+    RecompilerState state(blocks.front().pc);
+    state.SetLoadDelaySlot(true);
+    EmitBlockPrologue(emitter);
+    for (size_t i = 0u; i < blocks.size(); ++i) {
+        const BlockExtent& extent = extents[i];
+        EmitChargeCycles(emitter, extent.cycles);
+        Label unused = emitter.NewLabel();
+        if (!EmitBlockBody(state, emitter, memory, extent, unused)) {
+            EmitStorePC(emitter, state.GetPC());
+        }
+        if (i + 1u == blocks.size()) {
+            break;
+        }
+        // Leave by a side exit to the ordinary blocks if the branch didn't go the way it was profiled
+        const uint32_t next = blocks[i + 1u].pc;
+        Label stay = emitter.NewLabel();
+        emitter.MovR32Disp32(RAX, CONTEXT, static_cast<uint32_t>(R3051::PCOffset()));
+        emitter.CmpR32Imm32(RAX, next);
+        emitter.Je(stay);
+        EmitFlushHiLo(state, emitter);
+        EmitBlockEpilogue(emitter);
+        emitter.Bind(stay);
+        state.SetPC(next);
+    }
+    EmitFlushHiLo(state, emitter);
+    EmitBlockEpilogue(emitter);
+    return blocks;
+}
+
+}
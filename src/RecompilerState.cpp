@@ -1,5 +1,7 @@
 #include "RecomilerState.h"
 
+#include <algorithm>
+
 namespace rbrown {
 
 RecompilerState::RecompilerState(uint32_t startPc)
@@ -9,7 +11,12 @@ RecompilerState::RecompilerState(uint32_t startPc)
       branchTarget{},
       branchDelaySlot{},
       branchDelaySlotNext{},
-      pc{ startPc } {}
+      hiLoCached{},
+      hostRegisters{},
+      dirtyRegisters{},
+      pc{ startPc } {
+    std::fill(hostRegisters, hostRegisters + 32, NO_HOST_REGISTER);
+}
 
 uint32_t RecompilerState::GetLoadDelayRegister() const { return loadDelayRegister; }
 bool RecompilerState::GetLoadDelaySlot() const { return loadDelaySlot; }
@@ -18,6 +25,9 @@ bool RecompilerState::GetLoadDelaySlotNext() const { return loadDelaySlotNext; }
 uint32_t RecompilerState::GetBranchTarget() const { return branchTarget; }
 bool RecompilerState::GetBranchDelaySlot() const { return branchDelaySlot; }
 bool RecompilerState::GetBranchDelaySlotNext() const { return branchDelaySlotNext; }
+bool RecompilerState::GetHiLoCached() const { return hiLoCached; }
+uint32_t RecompilerState::GetHostRegister(uint32_t guest) const { return hostRegisters[guest]; }
+bool RecompilerState::GetHostRegisterDirty(uint32_t guest) const { return (dirtyRegisters >> guest) & 1u; }
 
 uint32_t RecompilerState::GetPC() const { return pc; }
 
@@ -28,6 +38,11 @@ void RecompilerState::SetLoadDelaySlotNext(bool v) { loadDelaySlotNext = v; }
 void RecompilerState::SetBranchTarget(uint32_t v) { branchTarget = v; }
 void RecompilerState::SetBranchDelaySlot(bool v) { branchDelaySlot = v; }
 void RecompilerState::SetBranchDelaySlotNext(bool v) { branchDelaySlotNext = v; }
+void RecompilerState::SetHiLoCached(bool v) { hiLoCached = v; }
+void RecompilerState::SetHostRegister(uint32_t guest, uint32_t host) { hostRegisters[guest] = host; }
+void RecompilerState::SetHostRegisterDirty(uint32_t guest, bool v) {
+    dirtyRegisters = v ? dirtyRegisters | (1u << guest) : dirtyRegisters & ~(1u << guest);
+}
 
 void RecompilerState::SetPC(uint32_t v) { pc = v; }
 
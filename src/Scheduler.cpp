@@ -0,0 +1,79 @@
+#include "Scheduler.h"
+#include "MIPS.h"
+
+#include <algorithm>
+
+namespace rbrown {
+
+namespace {
+
+// Without an event the processor still comes back now and again
+constexpr int32_t MAX_SLICE = 0x10000;
+
+// Orders the heap with the earliest event at the front
+bool Later(const ScheduledEvent& a, const ScheduledEvent& b) {
+    return a.due > b.due;
+}
+
+}
+
+Scheduler::Scheduler(R3051& r3051) :
+    processor { r3051 },
+    events { },
+    sliceStart { 0u },
+    sliceLength { 0 },
+    nextId { 1u } {
+    StartSlice();
+}
+
+uint64_t Scheduler::Now() const {
+    // Blocks charge their cycles on entry so this can run ahead by one block
+    return sliceStart + static_cast<uint64_t>(sliceLength - processor.GetDowncount());
+}
+
+uint32_t Scheduler::Schedule(uint64_t delay, EventCallback callback, void* context) {
+    const uint64_t due = Now() + delay;
+    const uint32_t id = nextId++;
+    events.push_back({ due, id, callback, context });
+    std::push_heap(events.begin(), events.end(), Later);
+    // Bring the end of the slice forward if this is now the earliest event
+    const uint64_t sliceEnd = sliceStart + static_cast<uint64_t>(sliceLength);
+    if (due < sliceEnd) {
+        const auto early = static_cast<int32_t>(sliceEnd - due);
+        sliceLength -= early;
+        processor.SetDowncount(processor.GetDowncount() - early);
+    }
+    return id;
+}
+
+void Scheduler::Cancel(uint32_t id) {
+    // Leaving the slice alone only means returning early for nothing
+    const auto it = std::find_if(events.begin(), events.end(), [id](const ScheduledEvent& e) { return e.id == id; });
+    if (it != events.end()) {
+        events.erase(it);
+        std::make_heap(events.begin(), events.end(), Later);
+    }
+}
+
+void Scheduler::RunEvents() {
+    // Events scheduled by a callback that are already due run straight away
+    const uint64_t now = Now();
+    while (!events.empty() && events.front().due <= now) {
+        std::pop_heap(events.begin(), events.end(), Later);
+        const ScheduledEvent event = events.back();
+        events.pop_back();
+        event.callback(event.context, event.due);
+    }
+    StartSlice();
+}
+
+void Scheduler::StartSlice() {
+    sliceStart = Now();
+    sliceLength = MAX_SLICE;
+    if (!events.empty()) {
+        sliceLength = static_cast<int32_t>(std::min<uint64_t>(events.front().due - sliceStart, MAX_SLICE));
+    }
+    processor.SetDowncount(sliceLength);
+}
+
+}
@@ -0,0 +1,87 @@
+#include "SpecializedInterpreter.h"
+#include "Decoder.h"
+#include "MIPS.h"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace rbrown {
+
+namespace {
+
+// Each operation is instantiated for every (rs, rt) pair, that's 1024 handlers
+// Specialising on rd as well would need 32768 handlers per R-type instruction
+// so R-type instructions take rd as their runtime operand instead
+
+template<uint32_t rs, uint32_t rt>
+struct Addiu {
+    static void Execute(R3051*, uint32_t* registers, uint32_t immediate) {
+        if constexpr (rt != 0u) {
+            registers[rt] = registers[rs] + immediate;
+        }
+    }
+};
+
+template<uint32_t rs, uint32_t rt>
+struct Addu {
+    static void Execute(R3051*, uint32_t* registers, uint32_t rd) {
+        registers[rd] = registers[rs] + registers[rt];
+        registers[0] = 0u;
+    }
+};
+
+template<uint32_t rs, uint32_t rt>
+struct Subu {
+    static void Execute(R3051*, uint32_t* registers, uint32_t rd) {
+        registers[rd] = registers[rs] - registers[rt];
+        registers[0] = 0u;
+    }
+};
+
+void Generic(R3051* processor, uint32_t*, uint32_t opcode) {
+    DecodeInstruction(opcode).interpret(processor, opcode);
+}
+
+constexpr size_t TABLE_SIZE = 32u * 32u;
+
+using SpecializedTable = std::array<SpecializedHandler, TABLE_SIZE>;
+
+template<template<uint32_t, uint32_t> class Operation, size_t... Index>
+constexpr SpecializedTable MakeTable(std::index_sequence<Index...>) {
+    return SpecializedTable { &Operation<Index / 32u, Index % 32u>::Execute... };
+}
+
+template<template<uint32_t, uint32_t> class Operation>
+constexpr SpecializedTable MakeTable() {
+    return MakeTable<Operation>(std::make_index_sequence<TABLE_SIZE>());
+}
+
+constexpr SpecializedTable ADDIU_TABLE = MakeTable<Addiu>();
+constexpr SpecializedTable ADDU_TABLE = MakeTable<Addu>();
+constexpr SpecializedTable SUBU_TABLE = MakeTable<Subu>();
+
+size_t TableIndex(uint32_t opcode) {
+    return InstructionRs(opcode) * 32u + InstructionRt(opcode);
+}
+
+}
+
+SpecializedInstruction Specialize(uint32_t opcode) {
+    // Operations without a specialisation run the decoder's interpreter function
+    switch (InstructionOp(opcode)) {
+        case 0x00: switch (InstructionFunction(opcode)) {
+            case 0x21: return { ADDU_TABLE[TableIndex(opcode)], InstructionRd(opcode) };
+            case 0x23: return { SUBU_TABLE[TableIndex(opcode)], InstructionRd(opcode) };
+            default:
+                break;
+        }
+        break;
+        case 0x09: return { ADDIU_TABLE[TableIndex(opcode)], InstructionImmediateExtended(opcode) };
+        default:
+            break;
+    }
+    return { Generic, opcode };
+}
+
+}